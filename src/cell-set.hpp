@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include "hash-map.hpp"
+
+/// open-addressing (linear probing) set of h3 indexes
+/// NOTE: 0 (H3_NULL) marks empty slots and can't be stored
+struct CellSet {
+  using value_type = uint64_t;
+  using size_type = size_t;
+
+  struct Iterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = uint64_t;
+    using difference_type = ptrdiff_t;
+    using pointer = const uint64_t*;
+    using reference = const uint64_t&;
+
+    Iterator(const uint64_t* it, const uint64_t* end) : it_(it), end_(end) { skip_empty(); }
+
+    reference operator*() const { return *it_; }
+
+    // Prefix increment
+    Iterator& operator++() {
+      ++it_;
+      skip_empty();
+      return *this;
+    }
+
+    friend bool operator==(const Iterator& x, const Iterator& y) { return x.it_ == y.it_; }
+    friend bool operator!=(const Iterator& x, const Iterator& y) { return !(x == y); }
+
+  private:
+    const uint64_t* it_;
+    const uint64_t* end_;
+
+    void skip_empty() {
+      while (it_ != end_ && *it_ == 0) ++it_;
+    }
+  };
+
+  using iterator = Iterator;
+  using const_iterator = Iterator;
+
+  CellSet() = default;
+  explicit CellSet(size_type n) { reserve(n); }
+  template <typename InputIt>
+  CellSet(InputIt first, InputIt last) {
+    insert(first, last);
+  }
+
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  iterator begin() const { return {slots_.data(), slots_.data() + slots_.size()}; }
+  iterator end() const { return {slots_.data() + slots_.size(), slots_.data() + slots_.size()}; }
+
+  // number of cells held without growing
+  size_type capacity() const { return slots_.size() / 2; }
+
+  void reserve(size_type n) {
+    if (n > capacity()) rehash(n);
+  }
+
+  // remove all cells, keeping (at most 4x) the memory of the last use for reuse
+  void clear() {
+    if (capacity() > 4 * std::max(size_, min_capacity))
+      rehash(size_, true);
+    else
+      std::fill(slots_.begin(), slots_.end(), 0);
+
+    size_ = 0;
+  }
+
+  size_type count(uint64_t cell) const {
+    if (cell == 0 || slots_.empty()) return 0;
+
+    for (size_t i = slot(cell);; i = next(i)) {
+      if (slots_[i] == cell) return 1;
+      if (slots_[i] == 0) return 0;
+    }
+  }
+
+  // returns true if `cell` was inserted
+  bool insert(uint64_t cell) {
+    if (cell == 0) return false;
+    if (size_ >= capacity()) rehash(2 * std::max(size_, min_capacity));
+
+    size_t i = slot(cell);
+    for (; slots_[i] != 0; i = next(i)) {
+      if (slots_[i] == cell) return false;
+    }
+
+    slots_[i] = cell;
+    ++size_;
+    return true;
+  }
+
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) insert(*first);
+  }
+
+  // returns number of cells removed
+  size_type erase(uint64_t cell) {
+    if (cell == 0 || slots_.empty()) return 0;
+
+    size_t i = slot(cell);
+    for (; slots_[i] != cell; i = next(i)) {
+      if (slots_[i] == 0) return 0;
+    }
+
+    // backward-shift deletion, moving later cells of the run into the hole
+    for (size_t j = next(i);; j = next(j)) {
+      if (slots_[j] == 0) break;
+
+      // can slots_[j] move to i? (its home slot isn't cyclically within (i, j])
+      size_t home = slot(slots_[j]);
+      if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j)) {
+        slots_[i] = slots_[j];
+        i = j;
+      }
+    }
+
+    slots_[i] = 0;
+    --size_;
+    return 1;
+  }
+
+private:
+  static constexpr size_type min_capacity = 8;
+
+  std::vector<uint64_t> slots_;
+  size_type size_ = 0;
+  // log2(slots_.size())
+  int bits_ = 0;
+
+  size_t next(size_t i) const { return (i + 1) & (slots_.size() - 1); }
+
+  size_t slot(uint64_t cell) const { return cell_hash(cell, bits_); }
+
+  // resize for `n` cells (at most 1/2 load)
+  void rehash(size_type n, bool shrink = false) {
+    int bits = 4;
+    while ((size_t{1} << (bits - 1)) < n) ++bits;
+
+    std::vector<uint64_t> slots(size_t{1} << bits, 0);
+    std::swap(slots_, slots);
+    bits_ = bits;
+
+    // cleared sets don't keep cells
+    if (shrink) return;
+
+    for (auto cell : slots) {
+      if (cell == 0) continue;
+
+      size_t i = slot(cell);
+      while (slots_[i] != 0) i = next(i);
+      slots_[i] = cell;
+    }
+  }
+};
+
+/// map of h3 indexes to their count & sum of weights
+/// NOTE: 0 (H3_NULL) can't be counted
+struct CellCounts {
+  using size_type = size_t;
+
+  struct Counts {
+    double count = 0;
+    double weight = 0;
+  };
+
+  size_type size() const { return counts_.size(); }
+  bool empty() const { return counts_.empty(); }
+
+  // count `cell` once more, adding `weight`
+  void add(uint64_t cell, double weight) {
+    if (cell == 0) return;
+
+    Counts& counts = *counts_.try_emplace(cell).first;
+    counts.count += 1;
+    counts.weight += weight;
+  }
+
+  // call `fn(cell, counts)` for every cell, in no particular order
+  template <typename Fn>
+  void for_each(const Fn& fn) const {
+    counts_.for_each(fn);
+  }
+
+private:
+  HashMap<uint64_t, Counts, CellHash> counts_;
+};
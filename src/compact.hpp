@@ -0,0 +1,394 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "cell-set.hpp"
+#include "h3/h3Index.h"
+#include "h3api.hpp"
+extern "C" {
+#include "h3/iterators.h"
+}
+#include "parallel.hpp"
+
+// sort-based compaction
+//
+// cells are ordered by their base cell & digits, where unused digits (7) sort a cell after all of
+// its descendants. this is a post-order walk of the hierarchy, so complete sets of siblings are
+// always the last cells seen when their last sibling (digit 6) arrives and can be merged on a stack.
+namespace h3 {
+
+/// digit bits finer than `res`
+constexpr uint64_t digits_after(int res) {
+  return (uint64_t{1} << (H3_PER_DIGIT_OFFSET * (MAX_H3_RES - res))) - 1;
+}
+
+namespace compact {
+
+/// base cell & digit bits, ordering cells hierarchically
+constexpr int key_bits = H3_RES_OFFSET;
+/// cells are partitioned by base cell & first 2 digits, bits above `partition_shift`
+constexpr int partition_shift = H3_BC_OFFSET - 2 * H3_PER_DIGIT_OFFSET;
+constexpr size_t n_partitions = size_t{1} << (key_bits - partition_shift);
+/// radix sort digit size, 3 passes for a partition
+constexpr int radix_bits = 13;
+/// sort fewer cells with std::sort
+constexpr size_t radix_min_size = 1024;
+
+inline uint64_t key(uint64_t cell) { return cell & ((uint64_t{1} << key_bits) - 1); }
+
+/// key of the first descendant, where cells span [first_key(cell), key(cell)]
+inline uint64_t first_key(uint64_t cell) { return key(cell) & ~digits_after(H3_GET_RESOLUTION(cell)); }
+
+/// bits of digit `res`
+inline uint64_t digit_mask(int res) { return uint64_t{H3_DIGIT_MASK} << (H3_PER_DIGIT_OFFSET * (MAX_H3_RES - res)); }
+
+/// sort cells by key, where keys only differ below `bits`
+inline void sort_cells(uint64_t* first, uint64_t* last, int bits, std::vector<uint64_t>& buffer) {
+  size_t size = last - first;
+  if (size < radix_min_size) {
+    std::sort(first, last, [](uint64_t x, uint64_t y) { return key(x) < key(y); });
+    return;
+  }
+
+  buffer.resize(size);
+  uint64_t* src = first;
+  uint64_t* dst = buffer.data();
+  std::vector<size_t> offsets(size_t{1} << radix_bits);
+
+  for (int shift = 0; shift < bits; shift += radix_bits) {
+    constexpr uint64_t mask = (uint64_t{1} << radix_bits) - 1;
+    std::fill(offsets.begin(), offsets.end(), 0);
+    for (auto it = src; it != src + size; it++) offsets[key(*it) >> shift & mask]++;
+
+    // every cell shares these bits
+    if (*std::max_element(offsets.begin(), offsets.end()) == size) continue;
+
+    size_t offset = 0;
+    for (auto& count : offsets) offset += std::exchange(count, offset);
+    for (auto it = src; it != src + size; it++) dst[offsets[key(*it) >> shift & mask]++] = *it;
+
+    std::swap(src, dst);
+  }
+
+  if (src != first) std::copy(src, src + size, first);
+}
+
+/// push `cell` onto the compacted cells [first, last), returning the new last
+/// NOTE: cells must be pushed in key order
+inline uint64_t* push_cell(uint64_t* first, uint64_t* last, uint64_t cell) {
+  // duplicate, or covered by an ancestor merged from its siblings
+  if (last != first && key(last[-1]) >= key(cell)) return last;
+
+  // descendants of cell
+  while (last != first && key(last[-1]) >= first_key(cell)) --last;
+  *last++ = cell;
+
+  // merge complete sets of siblings, repeating with their parent
+  for (int res = H3_GET_RESOLUTION(cell); res > 0; res--) {
+    uint64_t digit = digit_mask(res);
+    if ((cell & digit) != (uint64_t{6} << H3_PER_DIGIT_OFFSET * (MAX_H3_RES - res))) break;
+
+    // parent has coarser res & unused digit
+    uint64_t parent = (cell & ~H3_RES_MASK) | (uint64_t(res - 1) << H3_RES_OFFSET) | digit;
+    // pentagons have no k-axis child
+    ptrdiff_t n_siblings = isPentagon(parent) ? 6 : 7;
+    if (last - first < n_siblings) break;
+
+    // cells are distinct & not nested, so any n_siblings children of parent are complete
+    bool complete =
+        std::all_of(last - n_siblings, last, [&](uint64_t sibling) { return (sibling | digit) == (cell | digit); });
+    if (!complete) break;
+
+    last -= n_siblings;
+    *last++ = parent;
+    cell = parent;
+  }
+
+  return last;
+}
+
+/// push `cell` onto the compacted cells in `cells`
+inline void push_cell(std::vector<uint64_t>& cells, uint64_t cell) {
+  // room for cell
+  cells.push_back(cell);
+  uint64_t* last = push_cell(cells.data(), cells.data() + cells.size() - 1, cell);
+  cells.resize(last - cells.data());
+}
+
+/// compact sorted cells [first, last) in place, returning the new last
+inline uint64_t* compact_sorted(uint64_t* first, uint64_t* last) {
+  uint64_t* out = first;
+  for (auto it = first; it != last; it++) out = push_cell(first, out, *it);
+  return out;
+}
+
+inline size_t partition(uint64_t cell) { return key(cell) >> partition_shift; }
+};  // namespace compact
+
+/// replace complete sets of siblings with their parent, dropping duplicates and cells covered by an ancestor
+/// NOTE: cells of any resolution are accepted, and missing cells (`cell_at(i) == 0`) are skipped
+template <typename CellAt>
+std::vector<uint64_t> compact_cells(size_t size, int n_threads, const CellAt& cell_at) {
+  using namespace compact;
+
+  // per block partition counts, which become scatter offsets
+  size_t n_blocks = parallel::num_threads(n_threads);
+  size_t block_size = std::max<size_t>((size + n_blocks - 1) / n_blocks, 1);
+  std::vector<size_t> offsets(n_blocks * n_partitions);
+
+  parallel::for_each_chunk(
+      size, n_threads,
+      [&](size_t begin, size_t end) {
+        size_t* counts = &offsets[begin / block_size * n_partitions];
+        for (size_t i = begin; i < end; i++) {
+          uint64_t cell = cell_at(i);
+          if (cell != 0) counts[partition(cell)]++;
+        }
+      },
+      block_size);
+
+  // partitions are contiguous, in key order
+  std::vector<size_t> partition_begin(n_partitions + 1);
+  size_t offset = 0;
+  for (size_t p = 0; p < n_partitions; p++) {
+    partition_begin[p] = offset;
+    for (size_t b = 0; b < n_blocks; b++) offset += std::exchange(offsets[b * n_partitions + p], offset);
+  }
+  partition_begin[n_partitions] = offset;
+
+  std::vector<uint64_t> cells(offset);
+  parallel::for_each_chunk(
+      size, n_threads,
+      [&](size_t begin, size_t end) {
+        size_t* block_offsets = &offsets[begin / block_size * n_partitions];
+        for (size_t i = begin; i < end; i++) {
+          uint64_t cell = cell_at(i);
+          if (cell != 0) cells[block_offsets[partition(cell)]++] = cell;
+        }
+      },
+      block_size);
+
+  // sort & compact each partition, where siblings finer than res 2 are never split
+  std::vector<size_t> partition_end(n_partitions);
+  std::vector<std::vector<uint64_t>> buffers(parallel::num_threads(n_threads));
+
+  parallel::for_each_chunk(
+      n_partitions, n_threads,
+      [&](size_t begin, size_t end, size_t worker) {
+        for (size_t p = begin; p < end; p++) {
+          uint64_t* first = cells.data() + partition_begin[p];
+          uint64_t* last = cells.data() + partition_begin[p + 1];
+
+          sort_cells(first, last, partition_shift, buffers[worker]);
+          partition_end[p] = compact_sorted(first, last) - cells.data();
+        }
+      },
+      1);
+
+  // join partitions, merging the coarse cells they've compacted to
+  uint64_t* out = cells.data();
+  for (size_t p = 0; p < n_partitions; p++) {
+    uint64_t* first = cells.data() + partition_begin[p];
+    uint64_t* last = cells.data() + partition_end[p];
+
+    if (last - first == 1)
+      out = push_cell(cells.data(), out, *first);
+    else if (out != first)
+      out = std::copy(first, last, out);
+    else
+      out = last;
+  }
+
+  cells.resize(out - cells.data());
+  return cells;
+}
+
+/// replace complete sets of siblings with their parent, dropping cells covered by an ancestor
+inline H3Error compact_cells(CellSet& cells) {
+  std::vector<uint64_t> sorted(cells.begin(), cells.end());
+  std::vector<uint64_t> buffer;
+
+  compact::sort_cells(sorted.data(), sorted.data() + sorted.size(), compact::key_bits, buffer);
+  uint64_t* last = compact::compact_sorted(sorted.data(), sorted.data() + sorted.size());
+
+  cells.clear();
+  cells.insert(sorted.data(), last);
+  return E_SUCCESS;
+}
+
+/// uncompact cells to `res` in chunks, iterating children rather than allocating them all
+/// NOTE: missing cells (H3_NULL) are skipped
+struct UncompactStream {
+  UncompactStream(std::vector<uint64_t> cells, int res) : cells_(std::move(cells)), res_(res) {}
+
+  /// fill `out` with up to `capacity` children, setting `size` to the number filled (0 once exhausted)
+  H3Error next(uint64_t* out, size_t capacity, size_t& size) {
+    size = 0;
+
+    while (size < capacity) {
+      if (it_.h == H3_NULL) {
+        while (pos_ < cells_.size() && cells_[pos_] == H3_NULL) pos_++;
+        if (pos_ == cells_.size()) break;
+
+        uint64_t cell = cells_[pos_++];
+        if (res_ < 0 || res_ > MAX_H3_RES) return E_RES_DOMAIN;
+        if (getResolution(cell) > res_) return E_RES_MISMATCH;
+
+        it_ = iterInitParent(cell, res_);
+        continue;
+      }
+
+      out[size++] = it_.h;
+      iterStepChild(&it_);
+    }
+
+    return E_SUCCESS;
+  }
+
+  /// number of cells read, i.e. the 1-based position of a failing cell
+  size_t position() const { return pos_; }
+
+private:
+  std::vector<uint64_t> cells_;
+  int res_;
+  size_t pos_ = 0;
+  IterCellsChildren it_ = {H3_NULL, -1, -1};
+};
+
+// set algebra on sorted, compacted cells
+//
+// cells of a compacted set span disjoint key intervals, so overlapping cells are always nested and the
+// finer cell is the one with the smaller key. results are pushed in key order and compacted as they go.
+namespace compact {
+
+/// subtract sorted cells [first, last), all within `cell`, from `cell`
+inline void subtract(uint64_t cell, const uint64_t* first, const uint64_t* last, std::vector<uint64_t>& out) {
+  if (first == last) return push_cell(out, cell);
+  if (key(*first) == key(cell)) return;
+
+  // split cell into children, at least one of which is (partly) removed
+  for (auto it = iterInitParent(cell, H3_GET_RESOLUTION(cell) + 1); it.h != H3_NULL; iterStepChild(&it)) {
+    auto child_last = first;
+    while (child_last != last && key(*child_last) <= key(it.h)) child_last++;
+
+    subtract(it.h, first, child_last, out);
+    first = child_last;
+  }
+}
+};  // namespace compact
+
+/// cells in either of compacted sets x or y
+inline void set_union(const std::vector<uint64_t>& x, const std::vector<uint64_t>& y, std::vector<uint64_t>& out) {
+  using namespace compact;
+
+  size_t i = 0, j = 0;
+  while (i < x.size() || j < y.size()) {
+    if (j == y.size() || (i < x.size() && key(x[i]) <= key(y[j])))
+      push_cell(out, x[i++]);
+    else
+      push_cell(out, y[j++]);
+  }
+}
+
+/// cells in both compacted sets x and y
+inline void set_intersection(const std::vector<uint64_t>& x, const std::vector<uint64_t>& y,
+                             std::vector<uint64_t>& out) {
+  using namespace compact;
+
+  size_t i = 0, j = 0;
+  while (i < x.size() && j < y.size()) {
+    if (key(x[i]) < first_key(y[j]))
+      i++;
+    else if (key(y[j]) < first_key(x[i]))
+      j++;
+    // nested, keep the finer cell
+    else if (key(x[i]) <= key(y[j]))
+      push_cell(out, x[i++]);
+    else
+      push_cell(out, y[j++]);
+  }
+}
+
+/// cells in compacted set x but not y, splitting cells of x partly covered by y
+inline void set_difference(const std::vector<uint64_t>& x, const std::vector<uint64_t>& y,
+                           std::vector<uint64_t>& out) {
+  using namespace compact;
+
+  size_t j = 0;
+  for (auto cell : x) {
+    while (j < y.size() && key(y[j]) < first_key(cell)) j++;
+
+    // y cells within cell
+    size_t k = j;
+    while (k < y.size() && key(y[k]) <= key(cell)) k++;
+
+    // covered by an ancestor in y
+    bool covered = k < y.size() && first_key(y[k]) <= key(cell);
+    if (!covered) subtract(cell, y.data() + j, y.data() + k, out);
+
+    j = k;
+  }
+}
+
+/// is compacted set y within compacted set x?
+inline bool set_contains(const std::vector<uint64_t>& x, const std::vector<uint64_t>& y) {
+  using namespace compact;
+
+  size_t i = 0;
+  for (auto cell : y) {
+    // x cell spanning the end of cell, which must also span its start
+    while (i < x.size() && key(x[i]) < key(cell)) i++;
+    if (i == x.size() || first_key(x[i]) > first_key(cell)) return false;
+  }
+
+  return true;
+}
+
+/// the keys spanned by a cell and its descendants, labelled by `id`
+struct KeyRange {
+  uint64_t begin;
+  uint64_t end;
+  int id;
+  /// index of the range this one is within, or -1
+  int parent;
+};
+
+/// sort ranges of cells outer first, dropping repeats, and link each range to the one it's within
+/// NOTE: cells are never partly nested, so ranges containing a key are the last range beginning at
+/// or before it and its parents. `id` becomes the lowest id of a range and its parents.
+inline void nest_ranges(std::vector<KeyRange>& ranges) {
+  std::sort(ranges.begin(), ranges.end(), [](const KeyRange& x, const KeyRange& y) {
+    return x.begin != y.begin ? x.begin < y.begin : x.end != y.end ? x.end > y.end : x.id < y.id;
+  });
+  ranges.erase(std::unique(ranges.begin(), ranges.end(),
+                           [](const KeyRange& x, const KeyRange& y) { return x.begin == y.begin && x.end == y.end; }),
+               ranges.end());
+
+  // ranges each within the last
+  std::vector<int> open;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    while (!open.empty() && ranges[open.back()].end < ranges[i].begin) open.pop_back();
+
+    ranges[i].parent = open.empty() ? -1 : open.back();
+    if (!open.empty()) ranges[i].id = std::min(ranges[i].id, ranges[open.back()].id);
+    open.push_back(static_cast<int>(i));
+  }
+}
+
+/// index of the innermost range containing `cell`, among `size` ranges sorted by nest_ranges(), or -1
+/// NOTE: keys may be stored as any type holding them exactly, e.g. doubles in R vectors
+template <typename Key>
+int find_range(const Key* begins, const Key* ends, const int* parents, size_t size, uint64_t cell) {
+  auto first_key = static_cast<Key>(compact::first_key(cell));
+  auto key = static_cast<Key>(compact::key(cell));
+
+  // the last range beginning at or before the cell, or one of its (at most 15) parents
+  int i = static_cast<int>(std::upper_bound(begins, begins + size, first_key) - begins) - 1;
+  while (i >= 0 && ends[i] < key) i = parents[i];
+  return i;
+}
+
+};  // namespace h3
@@ -84,8 +84,40 @@ struct Arc {
   // great-circle length
   double length() const { return a.angle_to(b); }
 
-  // spherical linear interpolation
-  NVector slerp(const double frac) const { return (1 - frac) * a + frac * b; }
+  // unit tangent at a, heading towards b
+  // (near) antipodal points don't define a great circle, so any tangent at a will do
+  NVector tangent() const {
+    NVector tangent = b - (a * b) * a;
+    if (!(tangent.l2norm() > 1e-12)) tangent = a.cross(std::abs(a.z) < 0.9 ? NVector{0, 0, 1} : NVector{1, 0, 0});
+
+    // project out a again, lost to rounding when b is nearly parallel to a
+    tangent = tangent - (a * tangent) * a;
+    return tangent.normalise();
+  }
+};
+
+/// equally spaced points along an arc, from arc.a
+/// each point is rotated into the next about the arc's axis, so stepping needs no trig
+struct ArcStepper {
+  ArcStepper(const Arc& arc, const double step)
+      : point_(arc.a), tangent_(arc.tangent()), cos_step_(std::cos(step)), sin_step_(std::sin(step)) {}
+
+  const NVector& operator*() const { return point_; }
+
+  // Prefix increment
+  ArcStepper& operator++() {
+    NVector point = cos_step_ * point_ + sin_step_ * tangent_;
+    tangent_ = cos_step_ * tangent_ - sin_step_ * point_;
+    point_ = point;
+    return *this;
+  }
+
+private:
+  NVector point_;
+  // unit tangent at point_
+  NVector tangent_;
+  double cos_step_;
+  double sin_step_;
 };
 
 /// spherical arc string
@@ -121,8 +153,116 @@ struct ArcString {
   Iterator end() const { return coords.end() - !coords.empty(); }
 };
 
+/// index of closed arc string arcs by the planes through the y-axis they cross
+///
+/// CurvedRing::contains() only counts arcs crossing the plane through the y-axis & the
+/// tested point, so only the arcs binned with that plane's angle need testing.
+struct ArcIndex {
+  ArcIndex() = default;
+  ArcIndex(const std::vector<NVector>& coords, const NVector& centroid) {
+    const size_t n_arcs = coords.size() - 1;
+
+    // arc angle intervals, about the centroid's plane so a ring's intervals rarely wrap
+    origin_ = plane_angle(centroid) - M_PI_2;
+    std::vector<std::pair<double, double>> intervals(n_arcs);
+    double min_angle = M_PI;
+    double max_angle = 0;
+    double sweep = 0;
+
+    for (size_t i = 0; i < n_arcs; i++) {
+      const auto& a = coords[i];
+      const auto& b = coords[i + 1];
+
+      // an arc sweeps the shorter way between its endpoints' planes
+      double angle = wrap(plane_angle(a) - origin_, M_PI);
+      double delta = wrap(plane_angle(b) - plane_angle(a) + M_PI, 2 * M_PI) - M_PI;
+      double lo = angle + std::min(0.0, delta) - epsilon;
+      double hi = angle + std::max(0.0, delta) + epsilon;
+
+      // near the y-axis (any plane) or wrapping around
+      if (near_axis(a) || near_axis(b) || std::abs(delta) > M_PI - epsilon || lo < 0 || hi >= M_PI) {
+        all_.push_back(i);
+        intervals[i] = {1, 0};
+        continue;
+      }
+
+      intervals[i] = {lo, hi};
+      min_angle = std::min(min_angle, lo);
+      max_angle = std::max(max_angle, hi);
+      sweep += hi - lo;
+    }
+
+    if (max_angle <= min_angle) return;
+
+    // ~1 bin per arc sweep, so each arc is in ~1 bin
+    size_t n_bins = std::clamp<size_t>((max_angle - min_angle) * n_arcs / sweep, 1, n_arcs);
+    min_angle_ = min_angle;
+    scale_ = n_bins / (max_angle - min_angle);
+
+    // compressed bins, counting then filling
+    offsets_.assign(n_bins + 1, 0);
+    for (const auto& [lo, hi] : intervals) {
+      if (lo > hi) continue;
+      for (size_t bin = this->bin(lo); bin <= this->bin(hi); bin++) ++offsets_[bin + 1];
+    }
+
+    std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+    arcs_.resize(offsets_.back());
+
+    std::vector<uint32_t> next(offsets_.begin(), offsets_.end() - 1);
+    for (size_t i = 0; i < n_arcs; i++) {
+      const auto& [lo, hi] = intervals[i];
+      if (lo > hi) continue;
+      for (size_t bin = this->bin(lo); bin <= this->bin(hi); bin++) arcs_[next[bin]++] = i;
+    }
+  }
+
+  /// call `fn(i)` for every arc i (from coords[i] to coords[i + 1]) that could cross the plane
+  /// through the y-axis & `coord`
+  template <typename Fn>
+  void for_each_arc(const NVector& coord, const Fn& fn) const {
+    for (auto i : all_) fn(i);
+    if (offsets_.empty()) return;
+
+    size_t bin = this->bin(wrap(plane_angle(coord) - origin_, M_PI));
+    for (uint32_t j = offsets_[bin]; j < offsets_[bin + 1]; j++) fn(arcs_[j]);
+  }
+
+private:
+  static constexpr double epsilon = 1e-9;
+
+  // plane angles are offset so the centroid's plane is at pi / 2
+  double origin_ = 0;
+  // bins cover [min_angle_, min_angle_ + n_bins / scale_)
+  double min_angle_ = 0;
+  double scale_ = 0;
+  // arcs in every bin
+  std::vector<uint32_t> all_;
+  std::vector<uint32_t> offsets_;
+  std::vector<uint32_t> arcs_;
+
+  static double plane_angle(const NVector& vec) { return std::atan2(vec.z, vec.x); }
+
+  static bool near_axis(const NVector& vec) { return std::hypot(vec.x, vec.z) < epsilon; }
+
+  // wrap `angle` to [0, period)
+  static double wrap(const double angle, const double period) {
+    double wrapped = angle - period * std::floor(angle / period);
+    return wrapped < period ? wrapped : 0;
+  }
+
+  // angles outside the bins are clamped to the nearest
+  size_t bin(const double angle) const {
+    double bin = std::floor((angle - min_angle_) * scale_);
+    return std::clamp<double>(bin, 0, offsets_.size() - 2);
+  }
+};
+
 /// closed arc string
 struct CurvedRing : ArcString {
+  // arc midpoint mean direction, weighted by arc length so it doesn't follow dense vertices
+  NVector centroid = {0, 0, 0};
+
   CurvedRing() = default;
   CurvedRing(const std::vector<Coord>& coords) : CurvedRing(coords.cbegin(), coords.cend()) {}
   CurvedRing(std::vector<Coord>::const_iterator first, std::vector<Coord>::const_iterator last) {
@@ -134,26 +274,266 @@ struct CurvedRing : ArcString {
 
     // ensure ring is closed
     if (needs_close) coords.push_back(coords.front());
+
+    for (const auto&& [a, b] : *this) centroid = centroid + (0.5 * a.angle_to(b)) * (a + b);
+    prepare();
   }
 
   // point in closed arc string
   bool contains(const NVector& coord) const {
     if (coords.size() < 3) return false;
 
+    // outside the cap bounding every vertex (and so every arc), when it's within a hemisphere. this also
+    // excludes the antipodes of inside points, which have the same winding number
+    if (centroid * coord < cap_dist_) return false;
+
     // spherical winding number derived from
     // http://geomalgorithms.com/a03-_inclusion.html
     int wn = 0;
-    for (const auto&& [a, b] : *this) {
-      if (a.cross(coord).y <= 0) {
-        if (b.cross(coord).y > 0 && a.cross(b) * coord > 0) {
-          ++wn;
+    if (coords.size() < min_indexed_size) {
+      for (size_t i = 0; i < normals_.size(); i++) wn += winding(i, coord);
+    } else {
+      index_.for_each_arc(coord, [&](size_t i) { wn += winding(i, coord); });
+    }
+
+    if (wn == 0) return false;
+    if (!has_exterior_) return true;
+
+    // inside or the antipode of an inside point: inside crosses the ring an odd number of times on its way
+    // to an outside point (+/- exterior_, whichever is nearer)
+    const NVector outside = coord * exterior_ >= 0 ? exterior_ : -1 * exterior_;
+    const NVector normal = coord.cross(outside);
+
+    bool odd = false;
+    for (size_t i = 0; i < normals_.size(); i++) odd ^= crosses(coord, outside, normal, i);
+    return odd;
+  }
+
+private:
+  // rings with fewer coords are scanned
+  static constexpr size_t min_indexed_size = 32;
+
+  // arc normals, coords[i] x coords[i + 1]
+  std::vector<NVector> normals_;
+  // min centroid * vertex, when the bounding cap is within a hemisphere
+  double cap_dist_ = -INFINITY;
+  // without a bounding cap, a point with winding number 0, so outside as is its antipode
+  NVector exterior_ = {0, 0, 0};
+  bool has_exterior_ = false;
+  ArcIndex index_;
+
+  void prepare() {
+    if (coords.size() < 3) return;
+
+    normals_.reserve(coords.size() - 1);
+    for (const auto&& [a, b] : *this) normals_.push_back(a.cross(b));
+
+    double centroid_norm = centroid.l2norm();
+    if (centroid_norm > 1e-9) {
+      double cap_dist = INFINITY;
+      for (const auto& coord : coords) cap_dist = std::min(cap_dist, centroid * coord);
+
+      // caps wider than a hemisphere aren't convex, so arcs could leave them
+      if (cap_dist > 0) cap_dist_ = cap_dist - 1e-12 * centroid_norm;
+    }
+
+    if (cap_dist_ == -INFINITY) {
+      // rings whose inside & its antipode cover the sphere have none
+      const NVector candidates[] = {-1 * centroid, {0, 0, 1}, {1, 0, 0}, {0, 1, 0}};
+      for (const auto& candidate : candidates) {
+        if (!(candidate.l2norm() > 1e-9)) continue;
+
+        int wn = 0;
+        NVector unit = candidate.normalise();
+        for (size_t i = 0; i < normals_.size(); i++) wn += winding(i, unit);
+
+        if (wn == 0) {
+          exterior_ = unit;
+          has_exterior_ = true;
+          break;
+        }
+      }
+    }
+
+    if (coords.size() >= min_indexed_size) index_ = ArcIndex(coords, centroid);
+  }
+
+  // does arc i cross the (minor) arc from p to q, with normal p x q?
+  bool crosses(const NVector& p, const NVector& q, const NVector& normal, size_t i) const {
+    const auto& a = coords[i];
+    const auto& b = coords[i + 1];
+    if ((normal * a > 0) == (normal * b > 0)) return false;
+    if ((normals_[i] * p > 0) == (normals_[i] * q > 0)) return false;
+
+    // the great circles cross at +/- x, each minor arc at the one nearer its midpoint
+    NVector x = normal.cross(normals_[i]);
+    return ((a + b) * x > 0) == ((p + q) * x > 0);
+  }
+
+  // arc i's contribution to the winding number of `coord`
+  int winding(size_t i, const NVector& coord) const {
+    const auto& a = coords[i];
+    const auto& b = coords[i + 1];
+
+    if (a.cross(coord).y <= 0) {
+      if (b.cross(coord).y > 0 && normals_[i] * coord > 0) return 1;
+    } else if (b.cross(coord).y <= 0 && normals_[i] * coord < 0) {
+      return -1;
+    }
+
+    return 0;
+  }
+};
+
+/// index of rings by their bounding boxes in a gnomonic projection about `centre`
+///
+/// great-circle arcs project to straight lines, so a ring's box is its projected
+/// vertices' box. rings reaching `centre`'s far hemisphere are always candidates.
+struct RingIndex {
+  RingIndex() = default;
+  RingIndex(const std::vector<CurvedRing>& rings, const NVector& centre) {
+    const double centre_norm = centre.l2norm();
+    if (!(centre_norm > 1e-9)) {
+      for (size_t i = 0; i < rings.size(); i++) all_.push_back(i);
+      return;
+    }
+
+    // projection basis
+    normal_ = centre / centre_norm;
+    NVector axis = std::abs(normal_.x) < 0.9 ? NVector{1, 0, 0} : NVector{0, 1, 0};
+    u_ = normal_.cross(axis).normalise();
+    v_ = normal_.cross(u_);
+
+    boxes_.resize(rings.size(), {INFINITY, INFINITY, -INFINITY, -INFINITY});
+    Box bounds = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+
+    for (size_t i = 0; i < rings.size(); i++) {
+      auto& box = boxes_[i];
+      bool projected = !rings[i].coords.empty();
+
+      for (const auto& coord : rings[i].coords) {
+        double u, v;
+        if (!project(coord, u, v)) {
+          projected = false;
+          break;
         }
-      } else if (b.cross(coord).y <= 0 && a.cross(b) * coord < 0) {
-        --wn;
+
+        box = {std::min(box.u_min, u), std::min(box.v_min, v), std::max(box.u_max, u), std::max(box.v_max, v)};
       }
+
+      if (!projected) {
+        all_.push_back(i);
+        box = {1, 1, 0, 0};
+        continue;
+      }
+
+      // clear of rounding in projected coords
+      box = {box.u_min - epsilon, box.v_min - epsilon, box.u_max + epsilon, box.v_max + epsilon};
+
+      bounds = {std::min(bounds.u_min, box.u_min), std::min(bounds.v_min, box.v_min),
+                std::max(bounds.u_max, box.u_max), std::max(bounds.v_max, box.v_max)};
     }
 
-    return wn;
+    if (!(bounds.u_min <= bounds.u_max)) return;
+
+    // ~1 grid cell per ring
+    double width = std::max(bounds.u_max - bounds.u_min, epsilon);
+    double height = std::max(bounds.v_max - bounds.v_min, epsilon);
+    double size = std::sqrt(width * height / rings.size());
+    n_u_ = std::clamp<size_t>(std::ceil(width / size), 1, rings.size());
+    n_v_ = std::clamp<size_t>(std::ceil(height / size), 1, rings.size());
+    origin_u_ = bounds.u_min;
+    origin_v_ = bounds.v_min;
+    scale_u_ = n_u_ / width;
+    scale_v_ = n_v_ / height;
+
+    // compressed grid cells, counting then filling
+    offsets_.assign(n_u_ * n_v_ + 1, 0);
+    for_each_cell_of([&](size_t, size_t cell) { ++offsets_[cell + 1]; });
+    std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+    rings_.resize(offsets_.back());
+
+    std::vector<uint32_t> next(offsets_.begin(), offsets_.end() - 1);
+    for_each_cell_of([&](size_t i, size_t cell) { rings_[next[cell]++] = i; });
+  }
+
+  /// does `pred(i)` hold for any ring i whose box could contain `coord`?
+  template <typename Pred>
+  bool any_of(const NVector& coord, const Pred& pred) const {
+    for (auto i : all_) {
+      if (pred(i)) return true;
+    }
+
+    double u, v;
+    if (offsets_.empty() || !project(coord, u, v)) return false;
+
+    size_t cell = cell_u(u) * n_v_ + cell_v(v);
+    for (uint32_t j = offsets_[cell]; j < offsets_[cell + 1]; j++) {
+      const auto& box = boxes_[rings_[j]];
+      if (u < box.u_min || u > box.u_max || v < box.v_min || v > box.v_max) continue;
+      if (pred(rings_[j])) return true;
+    }
+
+    return false;
+  }
+
+private:
+  static constexpr double epsilon = 1e-12;
+
+  struct Box {
+    double u_min;
+    double v_min;
+    double u_max;
+    double v_max;
+  };
+
+  NVector normal_;
+  NVector u_;
+  NVector v_;
+  // rings in every grid cell
+  std::vector<uint32_t> all_;
+  // projected ring boxes
+  std::vector<Box> boxes_;
+  // n_u_ x n_v_ grid cells from (origin_u_, origin_v_)
+  size_t n_u_ = 0;
+  size_t n_v_ = 0;
+  double origin_u_ = 0;
+  double origin_v_ = 0;
+  double scale_u_ = 0;
+  double scale_v_ = 0;
+  std::vector<uint32_t> offsets_;
+  std::vector<uint32_t> rings_;
+
+  // gnomonic projection, for coords in the near hemisphere
+  bool project(const NVector& coord, double& u, double& v) const {
+    double dist = normal_ * coord;
+    if (dist < 1e-6) return false;
+
+    u = (u_ * coord) / dist;
+    v = (v_ * coord) / dist;
+    return true;
+  }
+
+  // coords outside the grid are clamped to the nearest cell
+  size_t cell_u(const double u) const {
+    return std::clamp<double>(std::floor((u - origin_u_) * scale_u_), 0, n_u_ - 1);
+  }
+
+  size_t cell_v(const double v) const {
+    return std::clamp<double>(std::floor((v - origin_v_) * scale_v_), 0, n_v_ - 1);
+  }
+
+  // call `fn(i, cell)` for every grid cell overlapping ring i's box
+  template <typename Fn>
+  void for_each_cell_of(const Fn& fn) const {
+    for (size_t i = 0; i < boxes_.size(); i++) {
+      const auto& box = boxes_[i];
+      if (box.u_min > box.u_max) continue;
+
+      for (size_t cu = cell_u(box.u_min); cu <= cell_u(box.u_max); cu++) {
+        for (size_t cv = cell_v(box.v_min); cv <= cell_v(box.v_max); cv++) fn(i, cu * n_v_ + cv);
+      }
+    }
   }
 };
 
@@ -180,16 +560,28 @@ struct CurvedPolygon {
 
       it += length;
     }
+
+    if (interiors.size() >= min_indexed_interiors) interiors_index_ = RingIndex(interiors, exterior.centroid);
   }
 
   // point in polygon
   bool contains(NVector coord) const {
     if (!exterior.contains(coord)) return false;
 
-    for (const auto& interior : interiors) {
-      if (interior.contains(coord)) return false;
+    if (interiors.size() < min_indexed_interiors) {
+      for (const auto& interior : interiors) {
+        if (interior.contains(coord)) return false;
+      }
+
+      return true;
     }
 
-    return true;
+    return !interiors_index_.any_of(coord, [&](size_t i) { return interiors[i].contains(coord); });
   }
+
+private:
+  // polygons with fewer interiors are scanned
+  static constexpr size_t min_indexed_interiors = 16;
+
+  RingIndex interiors_index_;
 };
@@ -0,0 +1,160 @@
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+#include <R_ext/Altrep.h>
+#include <R_ext/Rdynload.h>
+#include <algorithm>
+#include <string_view>
+
+extern "C" {
+#include "h3/iterators.h"
+}
+#include "h3api.hpp"
+#include "r-safe.hpp"
+#include "r-vector.hpp"
+#include "vctrs.hpp"
+
+// lazy children of a cell, an altrep real vector
+// data1: c(parent, child_res, size), data2: materialised cells or NULL
+namespace children {
+R_altrep_class_t cls;
+
+struct State {
+  H3Index parent;
+  int child_res;
+  R_xlen_t size;
+};
+
+inline State state(SEXP x) {
+  const double* data = REAL(R_altrep_data1(x));
+  return {bp::bit_cast<H3Index>(data[0]), static_cast<int>(data[1]), static_cast<R_xlen_t>(data[2])};
+}
+
+inline SEXP make(H3Index parent, int child_res, int64_t size) {
+  SEXP data1 = PROTECT(Rf_allocVector(REALSXP, 3));
+  REAL(data1)[0] = bp::bit_cast<double>(parent);
+  REAL(data1)[1] = child_res;
+  REAL(data1)[2] = static_cast<double>(size);
+
+  SEXP x = R_new_altrep(cls, data1, R_NilValue);
+  UNPROTECT(1);
+  return x;
+}
+
+/// iterate children from position `i`, without materialising
+R_xlen_t get_region(SEXP x, R_xlen_t i, R_xlen_t n, double* buf) {
+  State s = state(x);
+  R_xlen_t size = std::max<R_xlen_t>(std::min(n, s.size - i), 0);
+
+  SEXP data2 = R_altrep_data2(x);
+  if (data2 != R_NilValue) {
+    std::copy_n(REAL(data2) + i, size, buf);
+    return size;
+  }
+
+  IterCellsChildren it = iterInitChildPos(s.parent, s.child_res, i);
+  for (R_xlen_t j = 0; j < size; j++, iterStepChild(&it)) buf[j] = bp::bit_cast<double>(it.h);
+
+  return size;
+}
+
+R_xlen_t length(SEXP x) { return state(x).size; }
+
+double elt(SEXP x, R_xlen_t i) {
+  SEXP data2 = R_altrep_data2(x);
+  if (data2 != R_NilValue) return REAL(data2)[i];
+
+  State s = state(x);
+  H3Index child = h3_null;
+  H3_EXPORT(childPosToCell)(i, s.parent, s.child_res, &child);
+  return bp::bit_cast<double>(child);
+}
+
+void* dataptr(SEXP x, Rboolean writeable) {
+  SEXP data2 = R_altrep_data2(x);
+  if (data2 == R_NilValue) {
+    R_xlen_t size = length(x);
+    data2 = PROTECT(Rf_allocVector(REALSXP, size));
+    get_region(x, 0, size, REAL(data2));
+    R_set_altrep_data2(x, data2);
+    UNPROTECT(1);
+  }
+
+  return REAL(data2);
+}
+
+const void* dataptr_or_null(SEXP x) {
+  SEXP data2 = R_altrep_data2(x);
+  return data2 == R_NilValue ? nullptr : REAL(data2);
+}
+
+int no_na(SEXP x) { return 1; }
+
+Rboolean inspect(SEXP x, int pre, int deep, int pvec, void (*inspect_sub)(SEXP, int, int, int)) {
+  State s = state(x);
+  Rprintf("h3_children (parent=%llx, res=%i, %s)\n", static_cast<unsigned long long>(s.parent), s.child_res,
+          R_altrep_data2(x) == R_NilValue ? "lazy" : "materialised");
+  return TRUE;
+}
+
+SEXP serialized_state(SEXP x) { return R_altrep_data1(x); }
+
+SEXP unserialize(SEXP cls, SEXP state) { return R_new_altrep(children::cls, state, R_NilValue); }
+
+SEXP duplicate(SEXP x, Rboolean deep) {
+  // default duplicate copies materialised cells
+  if (R_altrep_data2(x) != R_NilValue) return nullptr;
+  return R_new_altrep(cls, R_altrep_data1(x), R_NilValue);
+}
+
+void init(DllInfo* dll) {
+  cls = R_make_altreal_class("h3_children", "h3r", dll);
+
+  R_set_altrep_Length_method(cls, length);
+  R_set_altrep_Inspect_method(cls, inspect);
+  R_set_altrep_Duplicate_method(cls, duplicate);
+  R_set_altrep_Serialized_state_method(cls, serialized_state);
+  R_set_altrep_Unserialize_method(cls, unserialize);
+
+  R_set_altvec_Dataptr_method(cls, dataptr);
+  R_set_altvec_Dataptr_or_null_method(cls, dataptr_or_null);
+
+  R_set_altreal_Elt_method(cls, elt);
+  R_set_altreal_Get_region_method(cls, get_region);
+  R_set_altreal_No_NA_method(cls, no_na);
+}
+};  // namespace children
+
+extern "C" void h3r_init_children(DllInfo* dll) { children::init(dll); }
+
+extern "C" SEXP ffi_h3_children(SEXP cells_sexp, SEXP child_res_sexp) {
+  return catch_unwind([&] {
+    vctr_view<uint64_t> cells = cells_sexp;
+    int child_res = Rf_asInteger(child_res_sexp);
+
+    vctr<SEXP> result(cells.size());
+    result.set_cls(vctrs_cls::list_of);
+
+    vctr<uint64_t> ptype;
+    ptype.set_cls(vctrs_cls::h3_cell);
+    result.set_ptype(ptype);
+
+    vctr<std::string_view> cell_cls = vctrs_cls::h3_cell;
+
+    for (R_xlen_t i = 0; i < cells.size(); i++) {
+      H3Index cell = cells[i];
+      if (h3_is_null(cell)) continue;
+
+      int64_t size;
+      if (H3Error err = H3_EXPORT(cellToChildrenSize)(cell, child_res, &size))
+        throw error("[%zu] H3 Error: %s", static_cast<size_t>(i) + 1, h3::fmt_error(err));
+
+      SEXP cell_children = PROTECT(children::make(cell, child_res, size));
+      Rf_setAttrib(cell_children, R_ClassSymbol, cell_cls);
+      result[i] = cell_children;
+      UNPROTECT(1);
+    }
+
+    return static_cast<SEXP>(result);
+  });
+}
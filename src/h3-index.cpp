@@ -1,32 +1,473 @@
 #define R_NO_REMAP
 #include <R.h>
 #include <Rinternals.h>
+#include <R_ext/Altrep.h>
+#include <R_ext/Rdynload.h>
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <string>
 
+#include "compact.hpp"
+#include "h3/h3Index.h"
 #include "h3api.hpp"
+#include "hash-map.hpp"
+#include "parallel.hpp"
 #include "r-safe.hpp"
 #include "r-vector.hpp"
 
-extern "C" SEXP ffi_string_to_h3(SEXP strings_sxp) {
+// strings repeat a few distinct indexes in many rows, so each distinct CHARSXP (interned by R) is
+// parsed/made once. memoisation stops past a budget of distinct values, however they're spread over rows.
+constexpr size_t memo_max_size = 1 << 20;
+
+/// are `n_distinct` values few enough to memoise?
+inline bool use_memo(size_t n_distinct) { return n_distinct <= memo_max_size; }
+
+inline std::string_view char_view(SEXP str) {
+  return str == NA_STRING ? std::string_view() : std::string_view(CHAR(str), LENGTH(str));
+}
+
+/// parse `strings` into `out` across `n_threads`, returning the first invalid string's index or SIZE_MAX
+size_t parse_strings(const std::vector<std::string_view>& strings, double* out, int n_threads) {
+  // first invalid string, reported as a serial loop would
+  std::atomic<size_t> err_idx = SIZE_MAX;
+
+  parallel::for_each_chunk(strings.size(), n_threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      H3Index h3_index;
+      if (!h3_parse(strings[i], h3_index)) {
+        size_t cur_idx = err_idx;
+        while (i < cur_idx && !err_idx.compare_exchange_weak(cur_idx, i)) {}
+        return;
+      }
+
+      out[i] = bp::bit_cast<double>(h3_index);
+    }
+  });
+
+  return err_idx;
+}
+
+extern "C" SEXP ffi_string_to_h3(SEXP strings_sxp, SEXP n_threads_sexp) {
   return catch_unwind([&] {
-    vctr_view<std::string_view> strings = strings_sxp;
-    vctr<H3Index> h3_indexes(strings.size());
+    vctr_view<std::string_view> strings_view = strings_sxp;
+    int n_threads = Rf_asInteger(n_threads_sexp);
+
+    size_t size = strings_view.size();
+    const SEXP* chars = STRING_PTR_RO(strings_sxp);
+
+    vctr<H3Index> h3_indexes(size);
+    double* out = REAL(h3_indexes);
+
+    // distinct strings in order of first use, with each element's id into them left in `out`
+    HashMap<SEXP, size_t, AddressHash> ids;
+    std::vector<std::string_view> strings;
+
+    size_t i = 0;
+    for (; i < size && use_memo(strings.size()); i++) {
+      auto [id, inserted] = ids.try_emplace(chars[i]);
+      if (inserted) {
+        *id = strings.size();
+        strings.push_back(char_view(chars[i]));
+      }
+
+      out[i] = bp::bit_cast<double>(uint64_t{*id});
+    }
+
+    if (i == size) {
+      // each distinct string parsed once, and the first invalid string is first used by the first invalid element
+      std::vector<double> parsed(strings.size());
+      if (size_t j = parse_strings(strings, parsed.data(), n_threads); j != SIZE_MAX) h3_from_str(strings[j]);
+
+      parallel::for_each_chunk(size, n_threads, [&](size_t begin, size_t end) {
+        for (size_t j = begin; j < end; j++) out[j] = parsed[bp::bit_cast<uint64_t>(out[j])];
+      });
 
-    std::transform(strings.begin(), strings.end(), h3_indexes.begin(), h3_from_str);
-    return h3_indexes;
+      return static_cast<SEXP>(h3_indexes);
+    }
+
+    // too many distinct strings, gathered on this thread (R API) then parsed without it
+    strings.resize(size);
+    std::transform(chars, chars + size, strings.begin(), char_view);
+
+    // throws the parse error
+    if (size_t j = parse_strings(strings, out, n_threads); j != SIZE_MAX) h3_from_str(strings[j]);
+
+    return static_cast<SEXP>(h3_indexes);
   });
 }
 
+/// format `h3_indexes` into `strings`, making each distinct CHARSXP once (see use_memo())
+void format_strings(const vctr_view<H3Index>& h3_indexes, SEXP strings) {
+  std::array<char, 17> buf;
+  auto make_char = [&buf](H3Index h3_index) {
+    std::string_view str = h3_to_str(h3_index, buf);
+    return Rf_mkCharLenCE(str.data(), str.size(), CE_BYTES);
+  };
+
+  // CHARSXPs are protected by `strings`
+  HashMap<uint64_t, SEXP, CellHash> chars;
+  bool memo = true;
+
+  for (R_xlen_t i = 0; i < h3_indexes.size(); i++) {
+    H3Index h3_index = h3_indexes[i];
+    if (h3_is_null(h3_index)) {
+      SET_STRING_ELT(strings, i, NA_STRING);
+      continue;
+    }
+
+    if (memo && !use_memo(chars.size())) {
+      chars = {};
+      memo = false;
+    }
+
+    // 0 marks empty slots of `chars`
+    if (!memo || h3_index == 0) {
+      SET_STRING_ELT(strings, i, make_char(h3_index));
+      continue;
+    }
+
+    auto [str, inserted] = chars.try_emplace(h3_index);
+    if (inserted) *str = make_char(h3_index);
+    SET_STRING_ELT(strings, i, *str);
+  }
+}
+
+// lazy identifiers of h3 indexes, an altrep string vector
+// data1: the indexes, or NULL once materialised
+// data2: formatted strings once materialised, else NULL or a list of chunks of formatted strings (NULL where none
+// were accessed, "" where not yet formatted)
+namespace h3_strings {
+R_altrep_class_t cls;
+
+// formatted strings are kept in chunks, so accessing a few doesn't allocate the whole vector
+constexpr R_xlen_t chunk_size = 4096;
+
+inline SEXP make(SEXP h3_indexes) { return R_new_altrep(cls, h3_indexes, R_NilValue); }
+
+R_xlen_t length(SEXP x) {
+  SEXP data1 = R_altrep_data1(x);
+  return Rf_xlength(data1 != R_NilValue ? data1 : R_altrep_data2(x));
+}
+
+/// format all elements, dropping the indexes
+SEXP materialise(SEXP x) {
+  SEXP data1 = R_altrep_data1(x);
+  if (data1 == R_NilValue) return R_altrep_data2(x);
+
+  SEXP data2 = PROTECT(Rf_allocVector(STRSXP, Rf_xlength(data1)));
+  format_strings(data1, data2);
+  R_set_altrep_data2(x, data2);
+  R_set_altrep_data1(x, R_NilValue);
+  UNPROTECT(1);
+  return data2;
+}
+
+SEXP elt(SEXP x, R_xlen_t i) {
+  SEXP data1 = R_altrep_data1(x);
+  if (data1 == R_NilValue) return STRING_ELT(R_altrep_data2(x), i);
+
+  H3Index h3_index = bp::bit_cast<H3Index>(REAL_ELT(data1, i));
+  if (h3_is_null(h3_index)) return NA_STRING;
+
+  // formatted strings are kept, as callers expect elements to be protected by the vector
+  R_xlen_t size = Rf_xlength(data1);
+  SEXP data2 = R_altrep_data2(x);
+  if (data2 == R_NilValue) {
+    data2 = PROTECT(Rf_allocVector(VECSXP, (size + chunk_size - 1) / chunk_size));
+    R_set_altrep_data2(x, data2);
+    UNPROTECT(1);
+  }
+
+  R_xlen_t chunk_idx = i / chunk_size;
+  SEXP chunk = VECTOR_ELT(data2, chunk_idx);
+  if (chunk == R_NilValue) {
+    chunk = PROTECT(Rf_allocVector(STRSXP, std::min(chunk_size, size - chunk_idx * chunk_size)));
+    SET_VECTOR_ELT(data2, chunk_idx, chunk);
+    UNPROTECT(1);
+  }
+
+  SEXP str = STRING_ELT(chunk, i % chunk_size);
+  if (str == R_BlankString) {
+    std::array<char, 17> buf;
+    std::string_view view = h3_to_str(h3_index, buf);
+    str = Rf_mkCharLenCE(view.data(), view.size(), CE_BYTES);
+    SET_STRING_ELT(chunk, i % chunk_size, str);
+  }
+
+  return str;
+}
+
+void set_elt(SEXP x, R_xlen_t i, SEXP value) { SET_STRING_ELT(materialise(x), i, value); }
+
+void* dataptr(SEXP x, Rboolean writeable) { return DATAPTR(materialise(x)); }
+
+const void* dataptr_or_null(SEXP x) {
+  return R_altrep_data1(x) == R_NilValue ? DATAPTR_RO(R_altrep_data2(x)) : nullptr;
+}
+
+Rboolean inspect(SEXP x, int pre, int deep, int pvec, void (*inspect_sub)(SEXP, int, int, int)) {
+  Rprintf("h3_strings (%s)\n", R_altrep_data1(x) == R_NilValue ? "materialised" : "lazy");
+  return TRUE;
+}
+
+// materialised strings are serialised as a regular vector
+SEXP serialized_state(SEXP x) {
+  SEXP data1 = R_altrep_data1(x);
+  return data1 != R_NilValue ? data1 : nullptr;
+}
+
+SEXP unserialize(SEXP cls, SEXP state) { return make(state); }
+
+SEXP duplicate(SEXP x, Rboolean deep) {
+  // default duplicate copies materialised strings
+  SEXP data1 = R_altrep_data1(x);
+  if (data1 == R_NilValue) return nullptr;
+  return make(data1);
+}
+
+void init(DllInfo* dll) {
+  cls = R_make_altstring_class("h3_strings", "h3r", dll);
+
+  R_set_altrep_Length_method(cls, length);
+  R_set_altrep_Inspect_method(cls, inspect);
+  R_set_altrep_Duplicate_method(cls, duplicate);
+  R_set_altrep_Serialized_state_method(cls, serialized_state);
+  R_set_altrep_Unserialize_method(cls, unserialize);
+
+  R_set_altvec_Dataptr_method(cls, dataptr);
+  R_set_altvec_Dataptr_or_null_method(cls, dataptr_or_null);
+
+  R_set_altstring_Elt_method(cls, elt);
+  R_set_altstring_Set_elt_method(cls, set_elt);
+}
+};  // namespace h3_strings
+
+extern "C" void h3r_init_strings(DllInfo* dll) { h3_strings::init(dll); }
+
 extern "C" SEXP ffi_h3_to_string(SEXP h3_indexes_sxp) {
   return catch_unwind([&] {
+    // checks the type, strings are formatted on access
     vctr_view<H3Index> h3_indexes = h3_indexes_sxp;
-    vctr<std::string_view> strings(h3_indexes.size());
+    return h3_strings::make(h3_indexes);
+  });
+}
 
-    std::array<char, 17> buf;
-    std::transform(h3_indexes.begin(), h3_indexes.end(), strings.begin(),
-                   [&buf](auto h3) { return h3_to_str(h3, buf); });
-    return strings;
+// hierarchy kernels, branch-free bit manipulation of whole vectors (see h3/h3Index.h)
+// NOTE: these stream at close to memory bandwidth without explicit SIMD
+
+/// first non-null index where `invalid(cell)`, for reporting kernel errors
+template <typename Fn>
+size_t first_invalid(const double* cells, size_t size, const Fn& invalid) {
+  for (size_t i = 0; i < size; i++) {
+    uint64_t cell = bp::bit_cast<uint64_t>(cells[i]);
+    if (!h3_is_null(cell) && invalid(cell)) return i;
+  }
+
+  return size;
+}
+
+extern "C" SEXP ffi_h3_resolution(SEXP cells_sexp) {
+  return catch_unwind([&] {
+    vctr_view<uint64_t> cells = cells_sexp;
+    vctr<int32_t> result(cells.size());
+
+    const double* in = REAL_RO(cells);
+    int* out = INTEGER(result);
+
+    for (R_xlen_t i = 0; i < cells.size(); i++) {
+      uint64_t cell = bp::bit_cast<uint64_t>(in[i]);
+      int res = H3_GET_RESOLUTION(cell);
+      out[i] = h3_is_null(cell) ? NA_INTEGER : res;
+    }
+
+    return static_cast<SEXP>(result);
+  });
+}
+
+extern "C" SEXP ffi_h3_base_cell(SEXP cells_sexp) {
+  return catch_unwind([&] {
+    vctr_view<uint64_t> cells = cells_sexp;
+    vctr<int32_t> result(cells.size());
+
+    const double* in = REAL_RO(cells);
+    int* out = INTEGER(result);
+
+    for (R_xlen_t i = 0; i < cells.size(); i++) {
+      uint64_t cell = bp::bit_cast<uint64_t>(in[i]);
+      int base_cell = H3_GET_BASE_CELL(cell);
+      out[i] = h3_is_null(cell) ? NA_INTEGER : base_cell;
+    }
+
+    return static_cast<SEXP>(result);
+  });
+}
+
+extern "C" SEXP ffi_h3_parent(SEXP cells_sexp, SEXP parent_res_sexp) {
+  return catch_unwind([&] {
+    vctr_view<uint64_t> cells = cells_sexp;
+    int parent_res = Rf_asInteger(parent_res_sexp);
+    if (parent_res < 0 || parent_res > MAX_H3_RES) throw error("H3 Error: %s", h3::fmt_error(E_RES_DOMAIN));
+
+    vctr<uint64_t> result(cells.size());
+    const double* in = REAL_RO(cells);
+    double* out = REAL(result);
+
+    // parent resolution, digits finer than it unused
+    const uint64_t parent_bits = (uint64_t(parent_res) << H3_RES_OFFSET) | h3::digits_after(parent_res);
+    // any cells coarser than parent_res?
+    bool invalid = false;
+
+    for (R_xlen_t i = 0; i < cells.size(); i++) {
+      uint64_t cell = bp::bit_cast<uint64_t>(in[i]);
+      bool is_null = h3_is_null(cell);
+      uint64_t parent = (cell & ~H3_RES_MASK) | parent_bits;
+
+      invalid |= !is_null & (H3_GET_RESOLUTION(cell) < parent_res);
+      out[i] = bp::bit_cast<double>(is_null ? cell : parent);
+    }
+
+    if (invalid) {
+      size_t i = first_invalid(in, cells.size(), [&](uint64_t cell) { return H3_GET_RESOLUTION(cell) < parent_res; });
+      throw error("[%zu] H3 Error: %s", i + 1, h3::fmt_error(E_RES_MISMATCH));
+    }
+
+    return static_cast<SEXP>(result);
+  });
+}
+
+extern "C" SEXP ffi_h3_center_child(SEXP cells_sexp, SEXP child_res_sexp) {
+  return catch_unwind([&] {
+    vctr_view<uint64_t> cells = cells_sexp;
+    int child_res = Rf_asInteger(child_res_sexp);
+    if (child_res < 0 || child_res > MAX_H3_RES) throw error("H3 Error: %s", h3::fmt_error(E_RES_DOMAIN));
+
+    vctr<uint64_t> result(cells.size());
+    const double* in = REAL_RO(cells);
+    double* out = REAL(result);
+
+    const uint64_t child_bits = uint64_t(child_res) << H3_RES_OFFSET;
+    const uint64_t child_digits = h3::digits_after(child_res);
+    // any cells finer than child_res?
+    bool invalid = false;
+
+    for (R_xlen_t i = 0; i < cells.size(); i++) {
+      uint64_t cell = bp::bit_cast<uint64_t>(in[i]);
+      bool is_null = h3_is_null(cell);
+      int res = H3_GET_RESOLUTION(cell);
+
+      // center child digits are 0, from res + 1 to child_res
+      uint64_t center_digits = h3::digits_after(res) & ~child_digits;
+      uint64_t child = ((cell & ~H3_RES_MASK) | child_bits) & ~center_digits;
+
+      invalid |= !is_null & (res > child_res);
+      out[i] = bp::bit_cast<double>(is_null ? cell : child);
+    }
+
+    if (invalid) {
+      size_t i = first_invalid(in, cells.size(), [&](uint64_t cell) { return H3_GET_RESOLUTION(cell) > child_res; });
+      throw error("[%zu] H3 Error: %s", i + 1, h3::fmt_error(E_RES_MISMATCH));
+    }
+
+    return static_cast<SEXP>(result);
+  });
+}
+
+extern "C" SEXP ffi_h3_compact(SEXP cells_sexp, SEXP n_threads_sexp) {
+  return catch_unwind([&] {
+    vctr_view<uint64_t> cells = cells_sexp;
+    int n_threads = Rf_asInteger(n_threads_sexp);
+
+    const double* in = REAL_RO(cells);
+    std::vector<uint64_t> compacted = h3::compact_cells(cells.size(), n_threads, [in](size_t i) {
+      uint64_t cell = bp::bit_cast<uint64_t>(in[i]);
+      return h3_is_null(cell) ? H3_NULL : cell;
+    });
+
+    vctr<uint64_t> result(compacted.size());
+    std::copy(compacted.begin(), compacted.end(), result.begin());
+    return static_cast<SEXP>(result);
   });
-}
\ No newline at end of file
+}
+
+extern "C" SEXP ffi_h3_uncompact(SEXP cells_sexp, SEXP res_sexp) {
+  return catch_unwind([&] {
+    vctr_view<uint64_t> cells = cells_sexp;
+    int res = Rf_asInteger(res_sexp);
+    if (res < 0 || res > MAX_H3_RES) throw error("H3 Error: %s", h3::fmt_error(E_RES_DOMAIN));
+
+    std::vector<uint64_t> compacted(cells.size());
+    std::transform(cells.begin(), cells.end(), compacted.begin(),
+                   [](uint64_t cell) { return h3_is_null(cell) ? H3_NULL : cell; });
+
+    int64_t size = 0;
+    for (size_t i = 0; i < compacted.size(); i++) {
+      if (compacted[i] == H3_NULL) continue;
+      if (getResolution(compacted[i]) > res) throw error("[%zu] H3 Error: %s", i + 1, h3::fmt_error(E_RES_MISMATCH));
+
+      int64_t n_children;
+      if (auto err = cellToChildrenSize(compacted[i], res, &n_children); err != E_SUCCESS)
+        throw error("[%zu] H3 Error: %s", i + 1, h3::fmt_error(err));
+      size += n_children;
+    }
+
+    vctr<uint64_t> result(size);
+    h3::UncompactStream stream(std::move(compacted), res);
+
+    std::array<uint64_t, 4096> chunk;
+    double* out = REAL(result);
+    size_t n;
+
+    do {
+      if (auto err = stream.next(chunk.data(), chunk.size(), n); err != E_SUCCESS)
+        throw error("[%zu] H3 Error: %s", stream.position(), h3::fmt_error(err));
+      out = std::transform(chunk.begin(), chunk.begin() + n, out,
+                           [](uint64_t cell) { return bp::bit_cast<double>(cell); });
+    } while (n > 0);
+
+    return static_cast<SEXP>(result);
+  });
+}
+
+void uncompact_stream_finalize(SEXP stream_xptr) {
+  delete static_cast<h3::UncompactStream*>(R_ExternalPtrAddr(stream_xptr));
+  R_ClearExternalPtr(stream_xptr);
+}
+
+extern "C" SEXP ffi_uncompact_stream_new(SEXP cells_sexp, SEXP res_sexp) {
+  return catch_unwind([&] {
+    vctr_view<uint64_t> cells = cells_sexp;
+    int res = Rf_asInteger(res_sexp);
+    if (res < 0 || res > MAX_H3_RES) throw error("H3 Error: %s", h3::fmt_error(E_RES_DOMAIN));
+
+    std::vector<uint64_t> compacted(cells.size());
+    std::transform(cells.begin(), cells.end(), compacted.begin(),
+                   [](uint64_t cell) { return h3_is_null(cell) ? H3_NULL : cell; });
+
+    SEXP stream_xptr = PROTECT(R_MakeExternalPtr(nullptr, R_NilValue, R_NilValue));
+    R_RegisterCFinalizerEx(stream_xptr, uncompact_stream_finalize, TRUE);
+    R_SetExternalPtrAddr(stream_xptr, new h3::UncompactStream(std::move(compacted), res));
+    UNPROTECT(1);
+
+    return stream_xptr;
+  });
+}
+
+extern "C" SEXP ffi_uncompact_stream_next(SEXP stream_xptr, SEXP chunk_size_sexp) {
+  return catch_unwind([&] {
+    auto* stream = static_cast<h3::UncompactStream*>(R_ExternalPtrAddr(stream_xptr));
+    if (stream == nullptr) throw std::invalid_argument("Uncompact stream is no longer valid");
+
+    int chunk_size = Rf_asInteger(chunk_size_sexp);
+    if (chunk_size == NA_INTEGER || chunk_size < 1) throw std::invalid_argument("chunk_size must be positive");
+
+    std::vector<uint64_t> chunk(chunk_size);
+    size_t n;
+    if (auto err = stream->next(chunk.data(), chunk.size(), n); err != E_SUCCESS)
+      throw error("[%zu] H3 Error: %s", stream->position(), h3::fmt_error(err));
+
+    vctr<uint64_t> result(n);
+    std::copy_n(chunk.begin(), n, result.begin());
+    return static_cast<SEXP>(result);
+  });
+}
@@ -0,0 +1,85 @@
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+#include <vector>
+
+#include "compact.hpp"
+#include "h3api.hpp"
+#include "parallel.hpp"
+#include "r-safe.hpp"
+#include "r-vector.hpp"
+
+// keys are below 2^52, so are stored exactly as doubles
+extern "C" SEXP ffi_h3_ranges_new(SEXP coverings_sexp) {
+  return catch_unwind([&] {
+    vctr_view<SEXP> coverings = coverings_sexp;
+
+    std::vector<h3::KeyRange> ranges;
+    for (R_xlen_t i = 0; i < coverings.size(); i++) {
+      SEXP cells_sexp = coverings[i];
+      if (Rf_isNull(cells_sexp)) continue;
+
+      for (uint64_t cell : vctr_view<uint64_t>(cells_sexp)) {
+        if (h3_is_null(cell)) continue;
+        if (!H3_EXPORT(isValidCell)(cell))
+          throw error("[%zu] H3 Error: %s", static_cast<size_t>(i) + 1, h3::fmt_error(E_CELL_INVALID));
+        ranges.push_back({h3::compact::first_key(cell), h3::compact::key(cell), static_cast<int>(i) + 1, -1});
+      }
+    }
+
+    h3::nest_ranges(ranges);
+
+    vctr<double> begin(ranges.size());
+    vctr<double> end(ranges.size());
+    vctr<int32_t> id(ranges.size());
+    vctr<int32_t> parent(ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++) {
+      begin[i] = static_cast<double>(ranges[i].begin);
+      end[i] = static_cast<double>(ranges[i].end);
+      id[i] = ranges[i].id;
+      parent[i] = ranges[i].parent;
+    }
+
+    vctr<SEXP> result(4);
+    result[0] = begin;
+    result[1] = end;
+    result[2] = id;
+    result[3] = parent;
+    return static_cast<SEXP>(result);
+  });
+}
+
+extern "C" SEXP ffi_h3_ranges_lookup(SEXP ranges_sexp, SEXP cells_sexp, SEXP n_threads_sexp) {
+  return catch_unwind([&] {
+    vctr_view<SEXP> ranges = ranges_sexp;
+    vctr_view<double> begin = ranges[0];
+    vctr_view<double> end = ranges[1];
+    vctr_view<int32_t> id = ranges[2];
+    vctr_view<int32_t> parent = ranges[3];
+    vctr_view<uint64_t> cells = cells_sexp;
+    int n_threads = Rf_asInteger(n_threads_sexp);
+
+    if (end.size() != begin.size() || id.size() != begin.size() || parent.size() != begin.size())
+      throw std::invalid_argument("Invalid h3_ranges");
+
+    const double* begins = REAL(begin);
+    const double* ends = REAL(end);
+    const int* ids = INTEGER(id);
+    const int* parents = INTEGER(parent);
+    size_t n_ranges = begin.size();
+
+    vctr<int32_t> result(cells.size());
+    int* out = INTEGER(result);
+    const double* in = REAL(cells_sexp);
+
+    parallel::for_each_chunk(cells.size(), n_threads, [&](size_t chunk_begin, size_t chunk_end) {
+      for (size_t i = chunk_begin; i < chunk_end; i++) {
+        auto cell = bp::bit_cast<uint64_t>(in[i]);
+        int j = h3_is_null(cell) ? -1 : h3::find_range(begins, ends, parents, n_ranges, cell);
+        out[i] = j >= 0 ? ids[j] : NA_INTEGER;
+      }
+    });
+
+    return static_cast<SEXP>(result);
+  });
+}
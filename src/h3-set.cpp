@@ -0,0 +1,86 @@
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+#include <vector>
+
+#include "compact.hpp"
+#include "h3api.hpp"
+#include "r-safe.hpp"
+#include "r-vector.hpp"
+
+enum class SetOp { Union, Intersection, Difference };
+
+/// read the `i`-th set of `sets`, which must be compacted & sorted (as by h3_compact())
+void read_set(const vctr_view<SEXP>& sets, R_xlen_t i, std::vector<uint64_t>& cells) {
+  cells.clear();
+
+  SEXP cells_sexp = sets[i];
+  if (Rf_isNull(cells_sexp)) return;
+
+  vctr_view<uint64_t> set = cells_sexp;
+  cells.reserve(set.size());
+
+  for (uint64_t cell : set) {
+    if (h3_is_null(cell)) continue;
+
+    // overlapping or out of order
+    if (!cells.empty() && h3::compact::key(cells.back()) >= h3::compact::first_key(cell))
+      throw error("[%zu] Set is not compacted & sorted, see h3_set()", static_cast<size_t>(i) + 1);
+
+    cells.push_back(cell);
+  }
+}
+
+extern "C" SEXP ffi_h3_set_op(SEXP x_sexp, SEXP y_sexp, SEXP op_sexp) {
+  return catch_unwind([&] {
+    vctr_view<SEXP> x_sets = x_sexp;
+    vctr_view<SEXP> y_sets = y_sexp;
+    auto op = SetOp{Rf_asInteger(op_sexp)};
+
+    vctr<SEXP> result(x_sets.size());
+    std::vector<uint64_t> x, y, cells;
+
+    for (R_xlen_t i = 0; i < x_sets.size(); i++) {
+      read_set(x_sets, i, x);
+      read_set(y_sets, i, y);
+
+      cells.clear();
+      switch (op) {
+        case SetOp::Union:
+          h3::set_union(x, y, cells);
+          break;
+        case SetOp::Intersection:
+          h3::set_intersection(x, y, cells);
+          break;
+        case SetOp::Difference:
+          h3::set_difference(x, y, cells);
+          break;
+      }
+
+      vctr<uint64_t> set(cells.size());
+      std::copy(cells.begin(), cells.end(), set.begin());
+      result[i] = set;
+    }
+
+    return static_cast<SEXP>(result);
+  });
+}
+
+extern "C" SEXP ffi_h3_set_contains(SEXP x_sexp, SEXP y_sexp) {
+  return catch_unwind([&] {
+    vctr_view<SEXP> x_sets = x_sexp;
+    vctr_view<SEXP> y_sets = y_sexp;
+
+    vctr<int32_t> result(x_sets.size());
+    int* out = INTEGER(result);
+    std::vector<uint64_t> x, y;
+
+    for (R_xlen_t i = 0; i < x_sets.size(); i++) {
+      read_set(x_sets, i, x);
+      read_set(y_sets, i, y);
+      out[i] = h3::set_contains(x, y);
+    }
+
+    return static_cast<SEXP>(result);
+  });
+}
@@ -32,6 +32,16 @@
 #include "latLng.h"
 #include "vec3d.h"
 
+// SSE2 is part of the x86-64 baseline, AVX2 is dispatched at run time
+#if defined(__x86_64__) || defined(_M_X64)
+#define H3_FACE_SIMD
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define H3_FACE_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
 /** square root of 7 */
 #define M_SQRT7 2.6457513110645905905016157536392604257102L
 
@@ -377,6 +387,42 @@ void _geoToFaceIjk(const LatLng *g, int res, FaceIJK *h) {
     _hex2dToCoordIJK(&v, &h->coord);
 }
 
+/**
+ * Encodes a batch of coordinates on the sphere to the FaceIJK addresses of the
+ * containing cells at the specified resolution. Equivalent to calling
+ * _geoToFaceIjk on each coordinate, but the closest face search runs over
+ * structure-of-arrays lanes.
+ *
+ * @param g The spherical coordinates to encode.
+ * @param n The number of coordinates, at most FACE_IJK_BATCH_SIZE.
+ * @param res The desired H3 resolution for the encoding.
+ * @param h The FaceIJK addresses of the containing cells at resolution res.
+ */
+void _geosToFaceIjks(const LatLng *g, int n, int res, FaceIJK *h) {
+    double x[FACE_IJK_BATCH_SIZE];
+    double y[FACE_IJK_BATCH_SIZE];
+    double z[FACE_IJK_BATCH_SIZE];
+    int face[FACE_IJK_BATCH_SIZE];
+    double sqd[FACE_IJK_BATCH_SIZE];
+
+    for (int i = 0; i < n; i++) {
+        Vec3d v3d;
+        _geoToVec3d(&g[i], &v3d);
+        x[i] = v3d.x;
+        y[i] = v3d.y;
+        z[i] = v3d.z;
+    }
+
+    _vec3dsToClosestFaces(x, y, z, n, face, sqd);
+
+    for (int i = 0; i < n; i++) {
+        Vec2d v;
+        h[i].face = face[i];
+        _geoFaceToHex2d(&g[i], res, &face[i], sqd[i], &v);
+        _hex2dToCoordIJK(&v, &h[i].coord);
+    }
+}
+
 /**
  * Encodes a coordinate on the sphere to the corresponding icosahedral face and
  * containing 2D hex coordinates relative to that face center.
@@ -390,7 +436,21 @@ void _geoToHex2d(const LatLng *g, int res, int *face, Vec2d *v) {
     // determine the icosahedron face
     double sqd;
     _geoToClosestFace(g, face, &sqd);
+    _geoFaceToHex2d(g, res, face, sqd, v);
+}
 
+/**
+ * Encodes a coordinate on the sphere to 2D hex coordinates relative to an
+ * already determined icosahedral face center.
+ *
+ * @param g The spherical coordinates to encode.
+ * @param res The desired H3 resolution for the encoding.
+ * @param face The icosahedral face containing the spherical coordinates.
+ * @param sqd The squared euclidean distance to the face center.
+ * @param v The 2D hex coordinates of the cell containing the point.
+ */
+void _geoFaceToHex2d(const LatLng *g, int res, const int *face, double sqd,
+                     Vec2d *v) {
     // cos(r) = 1 - 2 * sin^2(r/2) = 1 - 2 * (sqd / 4) = 1 - sqd/2
     double r = acos(1 - sqd / 2);
 
@@ -950,3 +1010,133 @@ void _geoToClosestFace(const LatLng *g, int *face, double *sqd) {
         }
     }
 }
+
+/**
+ * Scalar implementation of _vec3dsToClosestFaces.
+ */
+static void _vec3dsToClosestFacesScalar(const double *x, const double *y,
+                                        const double *z, int n, int *face,
+                                        double *sqd) {
+    for (int i = 0; i < n; i++) {
+        Vec3d v3d = {x[i], y[i], z[i]};
+
+        face[i] = 0;
+        sqd[i] = 5.0;
+        for (int f = 0; f < NUM_ICOSA_FACES; ++f) {
+            double sqdT = _pointSquareDist(&faceCenterPoint[f], &v3d);
+            if (sqdT < sqd[i]) {
+                face[i] = f;
+                sqd[i] = sqdT;
+            }
+        }
+    }
+}
+
+#ifdef H3_FACE_SIMD
+/**
+ * SSE2 implementation of _vec3dsToClosestFaces, 2 points per lane. Matches
+ * the scalar arithmetic operation for operation, so results are identical.
+ */
+static void _vec3dsToClosestFacesSse2(const double *x, const double *y,
+                                      const double *z, int n, int *face,
+                                      double *sqd) {
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d px = _mm_loadu_pd(x + i);
+        __m128d py = _mm_loadu_pd(y + i);
+        __m128d pz = _mm_loadu_pd(z + i);
+
+        __m128d best = _mm_set1_pd(5.0);
+        __m128d bestFace = _mm_setzero_pd();
+        for (int f = 0; f < NUM_ICOSA_FACES; ++f) {
+            __m128d dx = _mm_sub_pd(_mm_set1_pd(faceCenterPoint[f].x), px);
+            __m128d dy = _mm_sub_pd(_mm_set1_pd(faceCenterPoint[f].y), py);
+            __m128d dz = _mm_sub_pd(_mm_set1_pd(faceCenterPoint[f].z), pz);
+            __m128d sqdT = _mm_add_pd(
+                _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)),
+                _mm_mul_pd(dz, dz));
+
+            __m128d lt = _mm_cmplt_pd(sqdT, best);
+            best = _mm_or_pd(_mm_and_pd(lt, sqdT), _mm_andnot_pd(lt, best));
+            bestFace = _mm_or_pd(_mm_and_pd(lt, _mm_set1_pd(f)),
+                                 _mm_andnot_pd(lt, bestFace));
+        }
+
+        double faces[2];
+        _mm_storeu_pd(sqd + i, best);
+        _mm_storeu_pd(faces, bestFace);
+        face[i] = (int)faces[0];
+        face[i + 1] = (int)faces[1];
+    }
+
+    _vec3dsToClosestFacesScalar(x + i, y + i, z + i, n - i, face + i, sqd + i);
+}
+
+#ifdef H3_FACE_AVX2
+/**
+ * AVX2 implementation of _vec3dsToClosestFaces, 4 points per lane. Matches
+ * the scalar arithmetic operation for operation, so results are identical.
+ */
+__attribute__((target("avx2"))) static void _vec3dsToClosestFacesAvx2(
+    const double *x, const double *y, const double *z, int n, int *face,
+    double *sqd) {
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d px = _mm256_loadu_pd(x + i);
+        __m256d py = _mm256_loadu_pd(y + i);
+        __m256d pz = _mm256_loadu_pd(z + i);
+
+        __m256d best = _mm256_set1_pd(5.0);
+        __m256d bestFace = _mm256_setzero_pd();
+        for (int f = 0; f < NUM_ICOSA_FACES; ++f) {
+            __m256d dx =
+                _mm256_sub_pd(_mm256_set1_pd(faceCenterPoint[f].x), px);
+            __m256d dy =
+                _mm256_sub_pd(_mm256_set1_pd(faceCenterPoint[f].y), py);
+            __m256d dz =
+                _mm256_sub_pd(_mm256_set1_pd(faceCenterPoint[f].z), pz);
+            __m256d sqdT = _mm256_add_pd(
+                _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+                _mm256_mul_pd(dz, dz));
+
+            __m256d lt = _mm256_cmp_pd(sqdT, best, _CMP_LT_OQ);
+            best = _mm256_blendv_pd(best, sqdT, lt);
+            bestFace = _mm256_blendv_pd(bestFace, _mm256_set1_pd(f), lt);
+        }
+
+        _mm256_storeu_pd(sqd + i, best);
+        _mm_storeu_si128((__m128i *)(face + i), _mm256_cvttpd_epi32(bestFace));
+    }
+
+    _vec3dsToClosestFacesSse2(x + i, y + i, z + i, n - i, face + i, sqd + i);
+}
+#endif
+#endif
+
+/**
+ * Determines the closest icosahedral face for each of a batch of 3D
+ * coordinates, given as structure-of-arrays. Equivalent to
+ * _geoToClosestFace, picking the widest SIMD implementation the CPU
+ * supports at run time.
+ *
+ * @param x The x components of the 3D coordinates.
+ * @param y The y components of the 3D coordinates.
+ * @param z The z components of the 3D coordinates.
+ * @param n The number of coordinates.
+ * @param face The closest icosahedral face of each coordinate.
+ * @param sqd The squared euclidean distance to each closest face center.
+ */
+void _vec3dsToClosestFaces(const double *x, const double *y, const double *z,
+                           int n, int *face, double *sqd) {
+#if defined(H3_FACE_AVX2)
+    if (__builtin_cpu_supports("avx2")) {
+        _vec3dsToClosestFacesAvx2(x, y, z, n, face, sqd);
+        return;
+    }
+#endif
+#if defined(H3_FACE_SIMD)
+    _vec3dsToClosestFacesSse2(x, y, z, n, face, sqd);
+#else
+    _vec3dsToClosestFacesScalar(x, y, z, n, face, sqd);
+#endif
+}
@@ -70,10 +70,16 @@ typedef enum {
     NEW_FACE = 2
 } Overage;
 
+/** Maximum number of coordinates encoded by one _geosToFaceIjks call */
+#define FACE_IJK_BATCH_SIZE 64
+
 // Internal functions
 
 void _geoToFaceIjk(const LatLng *g, int res, FaceIJK *h);
+void _geosToFaceIjks(const LatLng *g, int n, int res, FaceIJK *h);
 void _geoToHex2d(const LatLng *g, int res, int *face, Vec2d *v);
+void _geoFaceToHex2d(const LatLng *g, int res, const int *face, double sqd,
+                     Vec2d *v);
 void _faceIjkToGeo(const FaceIJK *h, int res, LatLng *g);
 void _faceIjkToCellBoundary(const FaceIJK *h, int res, int start, int length,
                             CellBoundary *g);
@@ -86,5 +92,7 @@ Overage _adjustOverageClassII(FaceIJK *fijk, int res, int pentLeading4,
                               int substrate);
 Overage _adjustPentVertOverage(FaceIJK *fijk, int res);
 void _geoToClosestFace(const LatLng *g, int *face, double *sqd);
+void _vec3dsToClosestFaces(const double *x, const double *y, const double *z,
+                           int n, int *face, double *sqd);
 
 #endif
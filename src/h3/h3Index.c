@@ -790,6 +790,64 @@ H3Error H3_EXPORT(latLngToCell)(const LatLng *g, int res, H3Index *out) {
     }
 }
 
+/**
+ * Encodes a batch of coordinates on the sphere to the H3 indexes of the
+ * containing cells at the specified resolution. Results are identical to
+ * calling latLngToCell on each coordinate.
+ *
+ * Coordinates that fail to encode are set to H3_NULL and the first such error
+ * is returned, after the remaining coordinates have been encoded.
+ *
+ * @param g The spherical coordinates to encode.
+ * @param n The number of coordinates.
+ * @param res The desired H3 resolution for the encoding.
+ * @param out The encoded H3Indexes.
+ * @return E_SUCCESS (0) on success, another value otherwise
+ */
+H3Error H3_EXPORT(latLngsToCells)(const LatLng *g, int64_t n, int res,
+                                  H3Index *out) {
+    if (res < 0 || res > MAX_H3_RES) {
+        return E_RES_DOMAIN;
+    }
+
+    H3Error err = E_SUCCESS;
+    LatLng batch[FACE_IJK_BATCH_SIZE];
+    FaceIJK fijk[FACE_IJK_BATCH_SIZE];
+
+    for (int64_t begin = 0; begin < n; begin += FACE_IJK_BATCH_SIZE) {
+        int size = n - begin < FACE_IJK_BATCH_SIZE ? (int)(n - begin)
+                                                   : FACE_IJK_BATCH_SIZE;
+
+        // non-finite coordinates are replaced so the batch stays well defined
+        for (int i = 0; i < size; i++) {
+            const LatLng *gi = &g[begin + i];
+            if (isfinite(gi->lat) && isfinite(gi->lng)) {
+                batch[i] = *gi;
+            } else {
+                batch[i].lat = batch[i].lng = 0;
+            }
+        }
+
+        _geosToFaceIjks(batch, size, res, fijk);
+
+        for (int i = 0; i < size; i++) {
+            const LatLng *gi = &g[begin + i];
+            H3Index h = H3_NULL;
+            H3Error hErr = E_LATLNG_DOMAIN;
+
+            if (isfinite(gi->lat) && isfinite(gi->lng)) {
+                h = _faceIjkToH3(&fijk[i], res);
+                hErr = ALWAYS(h) ? E_SUCCESS : E_FAILED;
+            }
+
+            out[begin + i] = h;
+            if (!err) err = hErr;
+        }
+    }
+
+    return err;
+}
+
 /**
  * Convert an H3Index to the FaceIJK address on a specified icosahedral face.
  * @param h The H3Index.
@@ -204,6 +204,10 @@ typedef struct {
  */
 DECLSPEC H3Error H3_EXPORT(latLngToCell)(const LatLng *g, int res,
                                          H3Index *out);
+
+/** @brief find the H3 indexes of the cells containing a batch of lat/lng */
+DECLSPEC H3Error H3_EXPORT(latLngsToCells)(const LatLng *g, int64_t n, int res,
+                                           H3Index *out);
 /** @} */
 
 /** @defgroup cellToLatLng cellToLatLng
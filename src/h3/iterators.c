@@ -236,6 +236,33 @@ IterCellsChildren iterInitParent(H3Index h, int childRes) {
     return it;
 }
 
+/**
+ * Initialize a IterCellsChildren struct at the `childPos`-th child of cell `h`
+ * at resolution `childRes`, iterating through the remaining children.
+ *
+ * IterCellsChildren.h == H3_NULL if the inputs were invalid.
+ */
+IterCellsChildren iterInitChildPos(H3Index h, int childRes, int64_t childPos) {
+    IterCellsChildren it = iterInitParent(h, childRes);
+    if (it.h == H3_NULL) return it;
+
+    if (H3_EXPORT(childPosToCell)(childPos, h, childRes, &it.h) != E_SUCCESS) {
+        return _null_iter();
+    }
+
+    if (it._skipDigit != -1) {
+        // the skip digit is the last of the zero digits following the
+        // parent resolution
+        it._skipDigit = it._parentRes;
+        while (it._skipDigit < childRes &&
+               _getResDigit(&it, it._skipDigit + 1) == CENTER_DIGIT) {
+            it._skipDigit++;
+        }
+    }
+
+    return it;
+}
+
 /**
  * Step a IterCellsChildren to the next child cell.
  * When the iteration is over, IterCellsChildren.h will be H3_NULL.
@@ -55,6 +55,8 @@ typedef struct {
 
 DECLSPEC IterCellsChildren iterInitParent(H3Index h, int childRes);
 DECLSPEC IterCellsChildren iterInitBaseCellNum(int baseCellNum, int childRes);
+DECLSPEC IterCellsChildren iterInitChildPos(H3Index h, int childRes,
+                                            int64_t childPos);
 DECLSPEC void iterStepChild(IterCellsChildren *iter);
 
 /**
@@ -2,13 +2,16 @@
 
 #define R_NO_REMAP
 #include <R.h>
+#include <algorithm>
 #include <array>
 #include <charconv>
-#include <deque>
+#include <cstdint>
+#include <iterator>
 #include <stdexcept>
 #include <string>
 #include <system_error>
-#include <unordered_set>
+#include <vector>
+#include "cell-set.hpp"
 #include "errors.hpp"
 #include "geom.hpp"
 #include "h3/h3api.h"
@@ -18,13 +21,70 @@ const H3Index h3_null = bp::bit_cast<H3Index>(NA_REAL);
 
 inline bool h3_is_null(H3Index h3_index) { return h3_index == h3_null; }
 
-inline H3Index h3_from_str(std::string_view str) {
-  if (str.empty()) return h3_null;
+// fixed-width hex kernels, 8 digits at a time in a 64-bit word (SWAR), first digit in the lowest byte
+namespace hex {
+constexpr uint64_t ones = 0x0101010101010101;
+constexpr uint64_t high_bits = 0x80 * ones;
+
+/// decode 8 lowercase hex digits at `str`, returning false if any isn't [0-9a-f]
+inline bool decode8(const char* str, uint32_t& value) {
+  // compilers fold this into a single load on little-endian targets
+  uint64_t x = 0;
+  for (int i = 0; i < 8; i++) x |= uint64_t{static_cast<unsigned char>(str[i])} << (8 * i);
+
+  // bytes are ASCII, so comparisons by adding to each byte can't carry into the next
+  if (x & high_bits) return false;
+  auto at_least = [x](uint8_t lo) { return (x + (0x80 - lo) * ones) & high_bits; };
+  auto at_most = [x](uint8_t hi) { return ~(x + (0x7F - hi) * ones) & high_bits; };
+
+  uint64_t is_digit = at_least('0') & at_most('9');
+  uint64_t is_letter = at_least('a') & at_most('f');
+  if ((is_digit | is_letter) != high_bits) return false;
+
+  // nibble per byte, then pack pairs of bytes, words & halves with the first digit most significant
+  x = (x & (0x0F * ones)) + (is_letter >> 7) * 9;
+  x = ((x << 4) | (x >> 8)) & 0x00FF00FF00FF00FF;
+  x = ((x << 8) | (x >> 16)) & 0x0000FFFF0000FFFF;
+  x = ((x << 16) | (x >> 32)) & 0x00000000FFFFFFFF;
+
+  value = static_cast<uint32_t>(x);
+  return true;
+}
+
+/// encode `value` as 8 lowercase hex digits at `str`
+inline void encode8(uint32_t value, char* str) {
+  // unpack halves, words & pairs of bytes into a nibble per byte, the first digit in the lowest byte
+  uint64_t x = (value >> 16) | (uint64_t{value & 0xFFFF} << 32);
+  x = ((x >> 8) & 0x000000FF000000FF) | ((x & 0x000000FF000000FF) << 16);
+  x = ((x >> 4) & 0x000F000F000F000F) | ((x & 0x000F000F000F000F) << 8);
+
+  // '0' + nibble, skipping to 'a' for nibbles of 10+
+  uint64_t is_letter = ((x + 6 * ones) >> 4) & ones;
+  x += '0' * ones + is_letter * ('a' - '0' - 10);
+
+  for (int i = 0; i < 8; i++) str[i] = static_cast<char>(x >> (8 * i));
+}
+};  // namespace hex
+
+/// parse `str` into `h3_index`, returning false if it isn't a hex number (empty strings are null)
+inline bool h3_parse(std::string_view str, H3Index& h3_index) {
+  h3_index = h3_null;
+  if (str.empty()) return true;
+
+  // canonical indexes are 15 lowercase digits, read as overlapping digits 0-7 & 7-14
+  uint32_t high, low;
+  if (str.size() == 15 && hex::decode8(str.data(), high) && hex::decode8(str.data() + 7, low)) {
+    h3_index = (uint64_t{high} << 28) | (low & 0x0FFFFFFF);
+    return true;
+  }
 
-  H3Index h3_index = h3_null;
   auto [ptr, ec] = std::from_chars(str.begin(), str.end(), h3_index, 16);
+  return ec == std::errc() && *ptr == '\0';
+}
 
-  if (ec != std::errc() || *ptr != '\0')
+inline H3Index h3_from_str(std::string_view str) {
+  H3Index h3_index;
+  if (!h3_parse(str, h3_index))
     throw std::invalid_argument("'" + std::string(str) + "' is not a valid h3_index");
 
   return h3_index;
@@ -33,6 +93,13 @@ inline H3Index h3_from_str(std::string_view str) {
 inline std::string_view h3_to_str(H3Index h3_index, std::array<char, 17>& str) {
   if (h3_is_null(h3_index)) return std::string_view();
 
+  // 15 digits (cells), written as overlapping digits 0-7 & 7-14
+  if (h3_index >> 56 != 0 && h3_index >> 60 == 0) {
+    hex::encode8(static_cast<uint32_t>(h3_index >> 28), str.data());
+    hex::encode8(static_cast<uint32_t>(h3_index), str.data() + 7);
+    return std::string_view(str.data(), 15);
+  }
+
   auto [ptr, ec] = std::to_chars(str.begin(), str.end(), h3_index, 16);
 
   if (ec != std::errc()) throw std::invalid_argument(std::make_error_code(ec).message());
@@ -113,15 +180,15 @@ inline H3Error cell_to_nvector(const uint64_t cell, NVector* n_vector) {
 
 /// find cells at `res` intersecting `arc` by sampling
 /// NOTE: sampling doesn't include `arc.end`
-inline H3Error arc_to_cells(const Arc& arc, int res, std::unordered_set<uint64_t>& cells) {
+inline H3Error sample_arc_to_cells(const Arc& arc, int res, CellSet& cells) {
   // distance between arc samples at most 1/3 pentagon_radius apart
-  const double n_steps = std::ceil(3 * arc.length() / pentagon_radius(res));
-
-  for (uint64_t i = 0; i < n_steps; i++) {
-    NVector vec = arc.slerp(i / n_steps);
+  const double length = arc.length();
+  const uint64_t n_steps = std::ceil(3 * length / pentagon_radius(res));
+  ArcStepper vec(arc, length / n_steps);
 
+  for (uint64_t i = 0; i < n_steps; i++, ++vec) {
     uint64_t cell;
-    if (auto err = nvector_to_cell(vec, res, &cell); err != E_SUCCESS) return err;
+    if (auto err = nvector_to_cell(*vec, res, &cell); err != E_SUCCESS) return err;
 
     cells.insert(cell);
   }
@@ -129,8 +196,81 @@ inline H3Error arc_to_cells(const Arc& arc, int res, std::unordered_set<uint64_t
   return E_SUCCESS;
 }
 
+/// find cells at `res` intersecting `arc` by walking from cell to cell across the
+/// cell edges it crosses, so each cell is only looked up once
+/// NOTE: `arc.end`'s cell is only included when the walk reaches it
+inline H3Error arc_to_cells(const Arc& arc, int res, CellSet& cells) {
+  uint64_t cell, end_cell;
+  if (auto err = nvector_to_cell(arc.a, res, &cell); err != E_SUCCESS) return err;
+  if (auto err = nvector_to_cell(arc.b, res, &end_cell); err != E_SUCCESS) return err;
+
+  cells.insert(cell);
+  if (cell == end_cell) return E_SUCCESS;
+
+  // arc(theta) = cos(theta) * a + sin(theta) * tangent, for theta in [0, length]
+  const NVector normal = arc.a.cross(arc.b);
+  const double normal_norm = normal.l2norm();
+  // (near) antipodal endpoints don't define a great circle
+  if (!(normal_norm > 1e-12)) return sample_arc_to_cells(arc, res, cells);
+
+  const NVector axis = normal / normal_norm;
+  const NVector tangent = arc.tangent();
+  const double length = arc.length();
+  // step past an edge crossing, clear of where cellToBoundary & latLngToCell disagree
+  const double min_step = 1e-2 * pentagon_radius(res);
+  double step = min_step;
+
+  CellBoundary boundary;
+  double theta = 0;
+
+  while (cell != end_cell) {
+    if (auto err = cellToBoundary(cell, &boundary); err != E_SUCCESS) return err;
+
+    // last crossing of the cell's edges, where the arc leaves cell
+    double exit = theta;
+    NVector v = NVector::from_coord({boundary.verts[boundary.numVerts - 1]});
+
+    for (int i = 0; i < boundary.numVerts; i++) {
+      NVector w = NVector::from_coord({boundary.verts[i]});
+      NVector edge_normal = v.cross(w);
+
+      // arc & edge great circles cross at +/- x
+      NVector x = axis.cross(edge_normal);
+      double x_norm = x.l2norm();
+
+      if (x_norm > 0) {
+        x = x / x_norm;
+
+        // which of +/- x is within edge v -> w?
+        double v_side = v.cross(x) * edge_normal;
+        double w_side = x.cross(w) * edge_normal;
+        if (v_side <= 0 && w_side <= 0) x = -1 * x;
+
+        if ((v_side >= 0 && w_side >= 0) || (v_side <= 0 && w_side <= 0))
+          exit = std::max(exit, std::atan2(x * tangent, x * arc.a));
+      }
+
+      v = w;
+    }
+
+    theta = exit + step;
+    if (theta >= length) break;
+
+    uint64_t next_cell;
+    NVector vec = std::cos(theta) * arc.a + std::sin(theta) * tangent;
+    if (auto err = nvector_to_cell(vec, res, &next_cell); err != E_SUCCESS) return err;
+
+    // still in cell? its boundary is a little off, so step further
+    step = next_cell == cell ? 2 * step : min_step;
+    cell = next_cell;
+    cells.insert(cell);
+  }
+
+  return E_SUCCESS;
+}
+
 /// find cells at `res` intersecting `arc_string`
-inline H3Error arcstring_to_cells(const ArcString& arc_string, int res, std::unordered_set<uint64_t>& cells) {
+inline H3Error arcstring_to_cells(const ArcString& arc_string, int res, CellSet& cells) {
   for (const auto& arc : arc_string) {
     if (auto err = arc_to_cells(arc, res, cells); err != E_SUCCESS) return err;
   }
@@ -143,23 +283,38 @@ inline H3Error arcstring_to_cells(const ArcString& arc_string, int res, std::uno
   return E_SUCCESS;
 }
 
+/// scratch space for polygon fills, reused between polygons
+struct FillBuffers {
+  // cells intersecting polygon rings
+  CellSet edge_cells;
+  // edge cells & their ancestors
+  CellSet boundary_cells;
+  // cells that have been point-in-polygon tested
+  CellSet visited_cells;
+  // cells to visit
+  std::vector<uint64_t> pending_cells;
+};
+
 /// find cells at `res` intersecting `curved_polygon`
-inline H3Error curved_polygon_to_cells(const CurvedPolygon& curved_polygon, int res,
-                                       std::unordered_set<uint64_t>& cells) {
+inline H3Error curved_polygon_to_cells(const CurvedPolygon& curved_polygon, int res, CellSet& cells,
+                                       FillBuffers& buffers) {
   // edge cells intersecting polygon exterior or interior rings
-  std::unordered_set<uint64_t> edge_cells;
+  auto& edge_cells = buffers.edge_cells;
+  edge_cells.clear();
   if (auto err = arcstring_to_cells(curved_polygon.exterior, res, edge_cells); err != E_SUCCESS) return err;
 
   for (const auto& interior : curved_polygon.interiors) {
     if (auto err = arcstring_to_cells(interior, res, edge_cells); err != E_SUCCESS) return err;
   }
 
-  std::copy(edge_cells.begin(), edge_cells.end(), std::inserter(cells, cells.end()));
+  cells.insert(edge_cells.begin(), edge_cells.end());
 
   // interior cells whose neighbours are all interior or edge cells
-  std::deque<uint64_t> interior_cells;
+  auto& interior_cells = buffers.pending_cells;
+  interior_cells.clear();
   // cache of visited cells avoiding duplicate point-in-polygon tests
-  std::unordered_set<uint64_t> visited_cells;
+  auto& visited_cells = buffers.visited_cells;
+  visited_cells.clear();
   // disk cache
   std::array<uint64_t, 7> disk_cells;
 
@@ -169,7 +324,7 @@ inline H3Error curved_polygon_to_cells(const CurvedPolygon& curved_polygon, int
     for (int i = 1; i < 7; i++) {
       auto disk_cell = disk_cells[i];
       // not interior cell / already seen this cell?
-      if (disk_cell == 0 || edge_cells.count(disk_cell) || !visited_cells.insert(disk_cell).second) continue;
+      if (disk_cell == 0 || edge_cells.count(disk_cell) || !visited_cells.insert(disk_cell)) continue;
 
       NVector coord;
       if (auto err = cell_to_nvector(disk_cell, &coord); err != E_SUCCESS) return err;
@@ -183,16 +338,16 @@ inline H3Error curved_polygon_to_cells(const CurvedPolygon& curved_polygon, int
     }
   }
 
-  // now fill interior
+  // now fill interior, in any order
   while (!interior_cells.empty()) {
-    auto interior_cell = interior_cells.front();
-    interior_cells.pop_front();
+    auto interior_cell = interior_cells.back();
+    interior_cells.pop_back();
 
     if (auto err = gridDisk(interior_cell, 1, disk_cells.data()); err != E_SUCCESS) return err;
 
     for (int i = 1; i < 7; i++) {
       auto disk_cell = disk_cells[i];
-      if (disk_cell == 0 || !cells.insert(disk_cell).second) continue;
+      if (disk_cell == 0 || !cells.insert(disk_cell)) continue;
       interior_cells.push_back(disk_cell);
     }
   }
@@ -200,4 +355,138 @@ inline H3Error curved_polygon_to_cells(const CurvedPolygon& curved_polygon, int
   return E_SUCCESS;
 }
 
+/// find cells at `res` intersecting `curved_polygon`, testing coarse cells first
+/// NOTE: cells entirely within the polygon are found at the coarsest resolution possible
+/// NOTE: with `pad_edges`, edge cells' neighbours are edge cells too (and in `cells`), whether or not they
+/// intersect the polygon, so no other cell in `cells` can be clipped by a ring
+inline H3Error curved_polygon_to_compact_cells(const CurvedPolygon& curved_polygon, int res, CellSet& cells,
+                                               FillBuffers& buffers, bool pad_edges = false) {
+  // edge cells intersecting polygon exterior or interior rings
+  auto& edge_cells = buffers.edge_cells;
+  edge_cells.clear();
+  if (auto err = arcstring_to_cells(curved_polygon.exterior, res, edge_cells); err != E_SUCCESS) return err;
+
+  for (const auto& interior : curved_polygon.interiors) {
+    if (auto err = arcstring_to_cells(interior, res, edge_cells); err != E_SUCCESS) return err;
+  }
+
+  // rings are traced in steps, which can skip a cell a ring only clips, but not its neighbours too
+  if (pad_edges) {
+    auto& traced_cells = buffers.pending_cells;
+    traced_cells.assign(edge_cells.begin(), edge_cells.end());
+
+    std::array<uint64_t, 7> disk_cells;
+    for (auto traced_cell : traced_cells) {
+      if (auto err = gridDisk(traced_cell, 1, disk_cells.data()); err != E_SUCCESS) return err;
+      for (auto disk_cell : disk_cells) {
+        if (disk_cell != 0) edge_cells.insert(disk_cell);
+      }
+    }
+  }
+
+  // edge cells & their ancestors, the only cells needing refinement
+  auto& boundary_cells = buffers.boundary_cells;
+  boundary_cells.clear();
+  boundary_cells.insert(edge_cells.begin(), edge_cells.end());
+
+  for (auto edge_cell : edge_cells) {
+    for (int parent_res = res - 1; parent_res >= 0; parent_res--) {
+      uint64_t parent;
+      if (auto err = cellToParent(edge_cell, parent_res, &parent); err != E_SUCCESS) return err;
+      // ancestors already seen
+      if (!boundary_cells.insert(parent)) break;
+    }
+  }
+
+  auto& stack = buffers.pending_cells;
+  stack.resize(res0CellCount());
+  if (auto err = getRes0Cells(stack.data()); err != E_SUCCESS) return err;
+
+  // children cache
+  std::array<uint64_t, 7> children;
+
+  while (!stack.empty()) {
+    auto cell = stack.back();
+    stack.pop_back();
+
+    int cell_res = getResolution(cell);
+
+    if (boundary_cells.count(cell)) {
+      if (cell_res == res) {
+        cells.insert(cell);
+        continue;
+      }
+
+      // unused children (pentagons) are left as 0
+      children.fill(0);
+      if (auto err = cellToChildren(cell, cell_res + 1, children.data()); err != E_SUCCESS) return err;
+      std::copy_if(children.begin(), children.end(), std::back_inserter(stack), [](auto child) { return child != 0; });
+      continue;
+    }
+
+    // no edge cell descendants, so every descendant is inside (or outside) with the centroid
+    NVector coord;
+    if (auto err = cell_to_nvector(cell, &coord); err != E_SUCCESS) return err;
+
+    if (curved_polygon.contains(coord)) cells.insert(cell);
+  }
+
+  return E_SUCCESS;
+}
+
+/// replace cells coarser than `res` with their children at `res`
+inline H3Error uncompact_cells(CellSet& cells, int res) {
+  std::vector<uint64_t> coarse_cells;
+  std::copy_if(cells.begin(), cells.end(), std::back_inserter(coarse_cells),
+               [res](auto cell) { return getResolution(cell) < res; });
+
+  std::vector<uint64_t> children;
+  for (auto cell : coarse_cells) {
+    int64_t size;
+    if (auto err = cellToChildrenSize(cell, res, &size); err != E_SUCCESS) return err;
+
+    children.assign(size, 0);
+    if (auto err = cellToChildren(cell, res, children.data()); err != E_SUCCESS) return err;
+
+    cells.erase(cell);
+    for (auto child : children) {
+      if (child != 0) cells.insert(child);
+    }
+  }
+
+  return E_SUCCESS;
+}
+
+/// find cells at `res` whose centroid is within the polygon of `coords`, split into rings by `lengths`
+inline H3Error polygon_to_cells(const std::vector<Coord>& coords, const std::vector<size_t>& lengths, int res,
+                                CellSet& cells) {
+  static_assert(sizeof(Coord) == sizeof(LatLng));
+  if (coords.empty() || lengths.empty()) return E_SUCCESS;
+
+  // rings view `coords`, which polygonToCells doesn't modify
+  std::vector<GeoLoop> loops;
+  loops.reserve(lengths.size());
+
+  LatLng* verts = const_cast<Coord*>(coords.data());
+  for (auto length : lengths) {
+    loops.push_back({static_cast<int>(length), verts});
+    verts += length;
+  }
+
+  GeoPolygon polygon = {loops.front(), static_cast<int>(loops.size() - 1), loops.data() + 1};
+
+  int64_t size;
+  if (auto err = maxPolygonToCellsSize(&polygon, res, 0, &size); err != E_SUCCESS) return err;
+
+  // unused slots are left as 0
+  std::vector<H3Index> polygon_cells(size);
+  if (auto err = polygonToCells(&polygon, res, 0, polygon_cells.data()); err != E_SUCCESS) return err;
+
+  for (auto cell : polygon_cells) {
+    if (cell != 0) cells.insert(cell);
+  }
+
+  return E_SUCCESS;
+}
+
 };  // namespace h3
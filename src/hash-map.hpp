@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// fibonacci hash of the used digits, resolution & base cell of `cell`, in [0, 2^bits)
+inline size_t cell_hash(uint64_t cell, int bits) {
+  // unused digits (res + 1..15) are all 1s
+  int res = (cell >> 52) & 0xF;
+  uint64_t key = cell >> (3 * (15 - res));
+  return (key * 0x9E3779B97F4A7C15ULL) >> (64 - bits);
+}
+
+/// fibonacci hash of an address, in [0, 2^bits)
+struct AddressHash {
+  size_t operator()(const void* ptr, int bits) const {
+    // allocations are at least 8-byte aligned
+    uint64_t key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr)) >> 3;
+    return (key * 0x9E3779B97F4A7C15ULL) >> (64 - bits);
+  }
+};
+
+/// hash of an h3 index, in [0, 2^bits)
+struct CellHash {
+  size_t operator()(uint64_t cell, int bits) const { return cell_hash(cell, bits); }
+};
+
+/// open-addressing (linear probing) map
+/// NOTE: a value-initialised key (0, nullptr) marks empty slots and can't be stored
+template <typename Key, typename Value, typename Hash>
+struct HashMap {
+  using size_type = size_t;
+
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  /// value of `key`, value-initialised & returning true if it was inserted
+  /// NOTE: the pointer is invalidated by the next insert
+  std::pair<Value*, bool> try_emplace(Key key) {
+    if (size_ >= keys_.size() / 2) rehash(2 * std::max(size_, min_capacity));
+
+    size_t i = Hash()(key, bits_);
+    for (; keys_[i] != key; i = next(i)) {
+      if (keys_[i] == Key()) {
+        keys_[i] = key;
+        ++size_;
+        return {&values_[i], true};
+      }
+    }
+
+    return {&values_[i], false};
+  }
+
+  /// call `fn(key, value)` for every key, in no particular order
+  template <typename Fn>
+  void for_each(const Fn& fn) const {
+    for (size_t i = 0; i < keys_.size(); i++) {
+      if (keys_[i] != Key()) fn(keys_[i], values_[i]);
+    }
+  }
+
+private:
+  static constexpr size_type min_capacity = 8;
+
+  std::vector<Key> keys_;
+  std::vector<Value> values_;
+  size_type size_ = 0;
+  // log2(keys_.size())
+  int bits_ = 0;
+
+  size_t next(size_t i) const { return (i + 1) & (keys_.size() - 1); }
+
+  // resize for `n` keys (at most 1/2 load)
+  void rehash(size_type n) {
+    int bits = 4;
+    while ((size_t{1} << (bits - 1)) < n) ++bits;
+
+    std::vector<Key> keys(size_t{1} << bits, Key());
+    std::vector<Value> values(keys.size(), Value());
+    std::swap(keys_, keys);
+    std::swap(values_, values);
+    bits_ = bits;
+
+    for (size_t j = 0; j < keys.size(); j++) {
+      if (keys[j] == Key()) continue;
+
+      size_t i = Hash()(keys[j], bits_);
+      while (keys_[i] != Key()) i = next(i);
+      keys_[i] = keys[j];
+      values_[i] = values[j];
+    }
+  }
+};
@@ -7,29 +7,71 @@
 
 /* Section generated by pkgbuild, do not edit */
 /* .Call calls */
-extern SEXP ffi_cell_writer_new(void *);
+extern SEXP ffi_cell_count_writer_new(void *, void *, void *);
+extern SEXP ffi_cell_writer_new(void *, void *);
+extern SEXP ffi_h3_base_cell(void *);
+extern SEXP ffi_h3_center_child(void *, void *);
+extern SEXP ffi_h3_children(void *, void *);
+extern SEXP ffi_h3_compact(void *, void *);
+extern SEXP ffi_h3_parent(void *, void *);
+extern SEXP ffi_h3_ranges_lookup(void *, void *, void *);
+extern SEXP ffi_h3_ranges_new(void *);
+extern SEXP ffi_h3_resolution(void *);
+extern SEXP ffi_h3_set_contains(void *, void *);
+extern SEXP ffi_h3_set_op(void *, void *, void *);
 extern SEXP ffi_h3_to_string(void *);
+extern SEXP ffi_h3_uncompact(void *, void *);
 extern SEXP ffi_h3_version(void);
 extern SEXP ffi_handle_cell(void *, void *);
 extern SEXP ffi_handle_directed_edge(void *, void *);
 extern SEXP ffi_handle_vertex(void *, void *);
-extern SEXP ffi_listof_cell_writer_new(void *);
-extern SEXP ffi_string_to_h3(void *);
+extern SEXP ffi_listof_cell_writer_new(void *, void *, void *, void *);
+extern SEXP ffi_multires_cell_writer_new(void *, void *);
+extern SEXP ffi_polygon_index_join(void *, void *, void *);
+extern SEXP ffi_polygon_index_writer_new(void *, void *);
+extern SEXP ffi_string_to_h3(void *, void *);
+extern SEXP ffi_uncompact_stream_new(void *, void *);
+extern SEXP ffi_uncompact_stream_next(void *, void *);
+extern SEXP ffi_xy_to_cell(void *, void *, void *);
 
 static const R_CallMethodDef CallEntries[] = {
-    {"ffi_cell_writer_new",        (DL_FUNC) &ffi_cell_writer_new,        1},
+    {"ffi_cell_count_writer_new",  (DL_FUNC) &ffi_cell_count_writer_new,  3},
+    {"ffi_cell_writer_new",        (DL_FUNC) &ffi_cell_writer_new,        2},
+    {"ffi_h3_base_cell",           (DL_FUNC) &ffi_h3_base_cell,           1},
+    {"ffi_h3_center_child",        (DL_FUNC) &ffi_h3_center_child,        2},
+    {"ffi_h3_children",            (DL_FUNC) &ffi_h3_children,            2},
+    {"ffi_h3_compact",             (DL_FUNC) &ffi_h3_compact,             2},
+    {"ffi_h3_parent",              (DL_FUNC) &ffi_h3_parent,              2},
+    {"ffi_h3_ranges_lookup",       (DL_FUNC) &ffi_h3_ranges_lookup,       3},
+    {"ffi_h3_ranges_new",          (DL_FUNC) &ffi_h3_ranges_new,          1},
+    {"ffi_h3_resolution",          (DL_FUNC) &ffi_h3_resolution,          1},
+    {"ffi_h3_set_contains",        (DL_FUNC) &ffi_h3_set_contains,        2},
+    {"ffi_h3_set_op",              (DL_FUNC) &ffi_h3_set_op,              3},
     {"ffi_h3_to_string",           (DL_FUNC) &ffi_h3_to_string,           1},
+    {"ffi_h3_uncompact",           (DL_FUNC) &ffi_h3_uncompact,           2},
     {"ffi_h3_version",             (DL_FUNC) &ffi_h3_version,             0},
     {"ffi_handle_cell",            (DL_FUNC) &ffi_handle_cell,            2},
     {"ffi_handle_directed_edge",   (DL_FUNC) &ffi_handle_directed_edge,   2},
     {"ffi_handle_vertex",          (DL_FUNC) &ffi_handle_vertex,          2},
-    {"ffi_listof_cell_writer_new", (DL_FUNC) &ffi_listof_cell_writer_new, 1},
-    {"ffi_string_to_h3",           (DL_FUNC) &ffi_string_to_h3,           1},
+    {"ffi_listof_cell_writer_new", (DL_FUNC) &ffi_listof_cell_writer_new, 4},
+    {"ffi_multires_cell_writer_new", (DL_FUNC) &ffi_multires_cell_writer_new, 2},
+    {"ffi_polygon_index_join",     (DL_FUNC) &ffi_polygon_index_join,     3},
+    {"ffi_polygon_index_writer_new", (DL_FUNC) &ffi_polygon_index_writer_new, 2},
+    {"ffi_string_to_h3",           (DL_FUNC) &ffi_string_to_h3,           2},
+    {"ffi_uncompact_stream_new",   (DL_FUNC) &ffi_uncompact_stream_new,   2},
+    {"ffi_uncompact_stream_next",  (DL_FUNC) &ffi_uncompact_stream_next,  2},
+    {"ffi_xy_to_cell",             (DL_FUNC) &ffi_xy_to_cell,             3},
     {NULL, NULL, 0}
 };
 /* End section generated by pkgbuild */
 
+/* altrep classes */
+extern void h3r_init_children(DllInfo *dll);
+extern void h3r_init_strings(DllInfo *dll);
+
 void R_init_h3r(DllInfo *dll) {
     R_registerRoutines(dll, NULL, CallEntries, NULL, NULL);
     R_useDynamicSymbols(dll, FALSE);
+    h3r_init_children(dll);
+    h3r_init_strings(dll);
 }
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "r-interrupt.hpp"
+
+namespace parallel {
+
+/// default number of elements handed to a worker at a time
+constexpr size_t chunk_size = 1 << 16;
+
+/// number of threads to use for `n_threads`, where n_threads < 1 means all cores
+inline int num_threads(int n_threads) {
+  if (n_threads > 0) return n_threads;
+  return std::max(1U, std::thread::hardware_concurrency());
+}
+
+/// call `fn(begin, end)` for chunks of [0, size) across `n_threads` threads
+///
+/// chunks are claimed dynamically, so `fn` must only write to its own [begin, end).
+/// the calling thread takes part and is the only one checking for user interrupts,
+/// which (like any exception raised by `fn`) stop the remaining chunks and are
+/// rethrown on the calling thread once every worker has joined.
+///
+/// `fn(begin, end, worker)` is also accepted, where `worker` < num_threads(n_threads)
+/// identifies the calling thread (0 for the caller), e.g. to index per-thread buffers.
+template <typename Fn>
+void for_each_chunk(size_t size, int n_threads, const Fn& fn, size_t chunk = chunk_size) {
+  std::atomic<size_t> next = 0;
+  std::atomic<bool> stop = false;
+  std::exception_ptr err;
+  std::mutex err_mutex;
+
+  auto work = [&](size_t worker) {
+    try {
+      while (!stop) {
+        if (worker == 0) check_interrupt();
+
+        size_t begin = next.fetch_add(chunk);
+        if (begin >= size) break;
+
+        if constexpr (std::is_invocable_v<const Fn&, size_t, size_t, size_t>)
+          fn(begin, std::min(begin + chunk, size), worker);
+        else
+          fn(begin, std::min(begin + chunk, size));
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(err_mutex);
+      if (!err) err = std::current_exception();
+      stop = true;
+    }
+  };
+
+  // no point spawning workers for a single chunk
+  size_t n_workers = std::min<size_t>(num_threads(n_threads), (size + chunk - 1) / chunk);
+
+  std::vector<std::thread> workers;
+  if (n_workers > 1) workers.reserve(n_workers - 1);
+  for (size_t i = 1; i < n_workers; i++) {
+    // carry on with whatever threads we've got
+    try {
+      workers.emplace_back(work, i);
+    } catch (const std::system_error&) {
+      break;
+    }
+  }
+
+  work(0);
+  for (auto& worker : workers) worker.join();
+
+  if (err) std::rethrow_exception(err);
+}
+
+};  // namespace parallel
@@ -3,7 +3,10 @@
 #define R_NO_REMAP
 #include <R.h>
 #include <Rinternals.h>
+#include <array>
 #include <cstdint>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include "r-traits.hpp"
@@ -23,10 +26,23 @@ constexpr int sexp_type() {
     static_assert(unsupported<T>, "Unsupported type");
 }
 
+// int32, double & int64 are stored contiguously
+template <typename T>
+inline constexpr bool is_numeric_v = is_int32_v<T> || is_double_v<T> || is_int64_v<T>;
+
+// storage of numeric vectors
+template <typename T>
+using sexp_storage_t = std::conditional_t<is_int32_v<T>, int, double>;
+
 // a fancy pointer for r vectors
+// numeric vectors are read from their data pointer, or in regions when lazy (altrep) without one
 template <typename T, bool is_const = std::is_const_v<T>>
 struct vctr_ptr {
   struct value;
+  struct region;
+
+  using storage = sexp_storage_t<T>;
+  using storage_ptr = std::conditional_t<is_const, const storage*, storage*>;
 
   using iterator_category = std::random_access_iterator_tag;
   using value_type = value;
@@ -41,6 +57,15 @@ struct vctr_ptr {
     const int expected = sexp_type<T>();
     if (TYPEOF(data) != expected)
       throw std::invalid_argument("Expected "s + Rf_type2char(expected) + " vector"s);
+
+    if constexpr (is_numeric_v<T> && is_const) {
+      span_ = static_cast<storage_ptr>(DATAPTR_OR_NULL(data));
+      if (span_ == nullptr) region_ = std::make_shared<region>();
+    } else if constexpr (is_int32_v<T>) {
+      span_ = INTEGER(data);
+    } else if constexpr (is_numeric_v<T>) {
+      span_ = REAL(data);
+    }
   }
 
   SEXP data() const { return data_; }
@@ -107,23 +132,46 @@ struct vctr_ptr {
     void operator=(value value) { return ptr.set(idx, value); }
   };
 
+  // buffered elements of a lazy vector, from a multiple of `capacity`
+  struct region {
+    static constexpr size_type capacity = 1024;
+
+    size_type begin = 0;
+    size_type size = 0;
+    std::array<storage, capacity> buf;
+  };
+
 private:
   SEXP data_;
   size_type idx_;
+  storage_ptr span_ = nullptr;
+  // shared by copies, only without span_
+  std::shared_ptr<region> region_;
+
+  storage get_storage(size_type i) const {
+    if (span_ != nullptr) return span_[i];
+
+    region& r = *region_;
+    if (i < r.begin || i >= r.begin + r.size) {
+      r.begin = i - i % region::capacity;
+      if constexpr (is_int32_v<T>)
+        r.size = INTEGER_GET_REGION(data_, r.begin, region::capacity, r.buf.data());
+      else
+        r.size = REAL_GET_REGION(data_, r.begin, region::capacity, r.buf.data());
+    }
+
+    return r.buf[i - r.begin];
+  }
 
   // get underlying value
   T get(size_type i) const {
-    // int32
-    if constexpr (is_int32_v<T>)
-      return INTEGER_ELT(data_, i);
-
-    // double
-    else if constexpr (is_double_v<T>)
-      return REAL_ELT(data_, i);
+    // int32 & double
+    if constexpr (is_int32_v<T> || is_double_v<T>)
+      return get_storage(i);
 
     // int64
     else if constexpr (is_int64_v<T>)
-      return bp::bit_cast<T>(REAL_ELT(data_, i));
+      return bp::bit_cast<T>(get_storage(i));
 
     // string
     else if constexpr (is_string_v<T>) {
@@ -144,17 +192,13 @@ private:
   void set(size_type i, T value) const {
     static_assert(!is_const, "Unsupported for const");
 
-    // int32
-    if constexpr (is_int32_v<T>)
-      return SET_INTEGER_ELT(data_, i, value);
-
-    // double
-    else if constexpr (is_double_v<T>)
-      return SET_REAL_ELT(data_, i, value);
+    // int32 & double
+    if constexpr (is_int32_v<T> || is_double_v<T>)
+      span_[i] = value;
 
     // int64
     else if constexpr (is_int64_v<T>)
-      return SET_REAL_ELT(data_, i, bp::bit_cast<double>(value));
+      span_[i] = bp::bit_cast<double>(value);
 
     // string
     else if constexpr (is_string_v<T>) {
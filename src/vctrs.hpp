@@ -14,6 +14,8 @@ constexpr std::initializer_list<std::string_view> h3_directed_edge = {"h3_direct
 // h3_vertex
 constexpr std::initializer_list<std::string_view> h3_vertex = {"h3_vertex"sv, "h3_index"sv,
                                                                "vctrs_vctr"sv};
+// data.frame
+constexpr std::initializer_list<std::string_view> data_frame = {"data.frame"sv};
 // list_of
 constexpr std::initializer_list<std::string_view> list_of = {"vctrs_list_of"sv, "vctrs_vctr"sv,
                                                              "list"sv};
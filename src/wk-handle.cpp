@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <vector>
 #include "h3api.hpp"
+#include "parallel.hpp"
 #include "r-safe.hpp"
 #include "r-vector.hpp"
 #include "wk.hpp"
@@ -22,6 +23,9 @@ struct Reader {
 
   virtual Result read_feature(const T& feature) { throw std::logic_error("Not implemented"); }
 
+  // called with each chunk of features before they're read
+  virtual void read_chunk(const vctr_view<T>& features, size_t begin, size_t end) {}
+
   virtual SEXP read_features(const vctr_view<T>& features) {
     vector_meta_.size = features.size();
 
@@ -31,6 +35,9 @@ struct Reader {
     for (auto feature : features) {
       if (res == Result::Abort) break;
 
+      if (size_t i = feat_id_ + 1; i % read_chunk_size == 0)
+        read_chunk(features, i, std::min<size_t>(i + read_chunk_size, features.size()));
+
       ++feat_id_;
       res = next_.feature_start(&vector_meta_);
       if (res != Result::Continue) continue;
@@ -52,6 +59,8 @@ struct Reader {
   }
 
 protected:
+  static constexpr size_t read_chunk_size = 1 << 14;
+
   wk::NextHandler next_;
   wk_vector_meta_t vector_meta_;
   wk_meta_t meta_;
@@ -89,12 +98,27 @@ struct CellCentroidReader : Reader<uint64_t> {
 
 // read cell polygons
 struct CellPolygonReader : Reader<uint64_t> {
-  CellPolygonReader(wk::NextHandler next) : Reader(next) {
+  CellPolygonReader(wk::NextHandler next, int n_threads) : Reader(next), n_threads_(n_threads) {
     WK_VECTOR_META_RESET(vector_meta_, WK_POLYGON);
     WK_META_RESET(meta_, WK_POLYGON);
   }
 
+  // boundaries of a chunk of cells are computed up front, across threads
+  void read_chunk(const vctr_view<uint64_t>& cells, size_t begin, size_t end) override {
+    chunk_begin_ = begin;
+    cells_.assign(cells.begin() + begin, cells.begin() + end);
+    rings_.resize(cells_.size());
+
+    parallel::for_each_chunk(
+        cells_.size(), n_threads_,
+        [this](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; i++) rings_[i] = Ring::from_cell(cells_[i]);
+        },
+        1024);
+  }
+
   Result read_feature(const uint64_t& cell) override {
+    const Ring& ring = rings_[feat_id_ - chunk_begin_];
     bool not_null = !h3_is_null(cell);
     meta_.size = not_null;
 
@@ -102,33 +126,57 @@ struct CellPolygonReader : Reader<uint64_t> {
     if (res != Result::Continue) return res;
 
     if (not_null) {
-      CellBoundary boundary;
-      if (auto err = cellToBoundary(cell, &boundary); err != H3ErrorCodes::E_SUCCESS)
-        throw error("[%i] H3 Error: %s", cur_feat(), h3::fmt_error(err));
+      if (ring.err != H3ErrorCodes::E_SUCCESS)
+        throw error("[%i] H3 Error: %s", cur_feat(), h3::fmt_error(ring.err));
 
-      res = read_coords(boundary);
+      res = read_coords(ring);
       if (res != Result::Continue) return res;
     }
 
     return next_.geometry_end(&meta_);
   }
 
-  Result read_coords(const CellBoundary& boundary) {
-    uint32_t ring_size = boundary.numVerts + 1;
+private:
+  // closed cell boundary as x, y degrees
+  struct Ring {
+    H3Error err;
+    uint32_t size;
+    double coords[2 * (MAX_CELL_BNDRY_VERTS + 1)];
 
-    auto res = next_.ring_start(&meta_, ring_size);
-    if (res != Result::Continue) return res;
+    static Ring from_cell(uint64_t cell) {
+      Ring ring = {E_SUCCESS, 0, {}};
+      if (h3_is_null(cell)) return ring;
 
-    for (int i = 0; i < boundary.numVerts; i++) {
-      res = read_coord(boundary.verts[i]);
-      if (res != Result::Continue) return res;
+      CellBoundary boundary;
+      if (ring.err = cellToBoundary(cell, &boundary); ring.err != E_SUCCESS) return ring;
+
+      // close the polygon
+      ring.size = boundary.numVerts + 1;
+      for (uint32_t i = 0; i < ring.size; i++) {
+        const LatLng& vert = boundary.verts[i % boundary.numVerts];
+        ring.coords[2 * i] = radsToDegs(vert.lng);
+        ring.coords[2 * i + 1] = radsToDegs(vert.lat);
+      }
+
+      return ring;
     }
+  };
 
-    // close the polygon
-    res = read_coord(boundary.verts[0]);
+  int n_threads_;
+  size_t chunk_begin_ = 0;
+  std::vector<uint64_t> cells_;
+  std::vector<Ring> rings_;
+
+  Result read_coords(const Ring& ring) {
+    auto res = next_.ring_start(&meta_, ring.size);
     if (res != Result::Continue) return res;
 
-    return next_.ring_end(&meta_, ring_size);
+    for (uint32_t i = 0; i < ring.size; i++) {
+      res = next_.coord(&meta_, ring.coords + 2 * i);
+      if (res != Result::Continue) return res;
+    }
+
+    return next_.ring_end(&meta_, ring.size);
   }
 };
 
@@ -193,9 +241,10 @@ SEXP handle_cell(SEXP data, wk_handler_t* handler) {
   return catch_unwind([&] {
     vctr_view<uint64_t> cells = VECTOR_ELT(data, 0);
     auto type = Rf_asInteger(VECTOR_ELT(data, 1));
+    auto n_threads = Rf_asInteger(VECTOR_ELT(data, 2));
 
     if (type == 1) {
-      CellPolygonReader reader(handler);
+      CellPolygonReader reader(handler, n_threads);
       return reader.read_features(cells);
     }
 
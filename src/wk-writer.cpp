@@ -2,21 +2,117 @@
 #include <R.h>
 #include <Rinternals.h>
 #include <algorithm>
-#include <numeric>
-#include <unordered_set>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
+#include "compact.hpp"
 #include "h3api.hpp"
+#include "parallel.hpp"
 #include "r-vector.hpp"
 #include "vctrs.hpp"
 #include "wk.hpp"
 
+/// throw the error indexing `point` at `res`, the `id`-th element
+[[noreturn]] inline void stop_point(size_t id, const LatLng& point, int res) {
+  uint64_t cell;
+  auto err = latLngToCell(&point, res, &cell);
+  throw error("[%zu] H3 Error: %s", id, h3::fmt_error(err));
+}
+
+/// index `size` points at `res` across `n_threads`, calling `cell_fn(i, cell)` for each
+///
+/// `point_at(i, point)` fills the i-th point, returning false for null points (whose cell is h3_null).
+/// returns the index of the first point that couldn't be indexed (see stop_point()), or SIZE_MAX
+template <typename PointFn, typename CellFn>
+size_t for_each_point_cell(size_t size, int res, int n_threads, const PointFn& point_at, const CellFn& cell_fn) {
+  // first failing point, reported as a serial loop would
+  std::atomic<size_t> err_idx = SIZE_MAX;
+
+  parallel::for_each_chunk(size, n_threads, [&](size_t begin, size_t end) {
+    // latLngsToCells batches
+    constexpr size_t batch_size = 256;
+    std::array<LatLng, batch_size> points;
+    std::array<bool, batch_size> not_null;
+    std::array<uint64_t, batch_size> batch;
+
+    for (size_t i = begin; i < end; i += batch_size) {
+      size_t n = std::min(batch_size, end - i);
+
+      for (size_t j = 0; j < n; j++) {
+        not_null[j] = point_at(i + j, points[j]);
+        if (!not_null[j]) points[j] = {0, 0};
+      }
+
+      // failed cells are left as 0
+      batch.fill(0);
+      if (latLngsToCells(points.data(), n, res, batch.data()) != E_SUCCESS) {
+        size_t j = 0;
+        while (j < n && !(not_null[j] && batch[j] == 0)) j++;
+
+        if (j < n) {
+          size_t cur_idx = err_idx;
+          while (i + j < cur_idx && !err_idx.compare_exchange_weak(cur_idx, i + j)) {}
+          return;
+        }
+      }
+
+      for (size_t j = 0; j < n; j++) cell_fn(i + j, not_null[j] ? batch[j] : h3_null);
+    }
+  });
+
+  return err_idx;
+}
+
+/// index `size` points at `res` into `cells` across `n_threads`
+template <typename PointFn>
+void points_to_cells(double* cells, size_t size, int res, int n_threads, const PointFn& point_at) {
+  size_t i = for_each_point_cell(size, res, n_threads, point_at,
+                                 [cells](size_t i, uint64_t cell) { cells[i] = bp::bit_cast<double>(cell); });
+
+  if (i != SIZE_MAX) {
+    LatLng point;
+    point_at(i, point);
+    stop_point(i + 1, point, res);
+  }
+}
+
+/// point coordinates of `xy_sexp`, a list of x, y or a 2-column matrix, returning the number of points
+size_t read_xy(SEXP xy_sexp, const double*& x, const double*& y) {
+  if (TYPEOF(xy_sexp) == VECSXP && Rf_xlength(xy_sexp) >= 2) {
+    SEXP x_sexp = VECTOR_ELT(xy_sexp, 0);
+    SEXP y_sexp = VECTOR_ELT(xy_sexp, 1);
+    if (TYPEOF(x_sexp) != REALSXP || TYPEOF(y_sexp) != REALSXP)
+      throw std::invalid_argument("Expected double x and y vectors");
+    if (Rf_xlength(x_sexp) != Rf_xlength(y_sexp)) throw std::invalid_argument("Expected x and y of the same length");
+
+    x = REAL_RO(x_sexp);
+    y = REAL_RO(y_sexp);
+    return Rf_xlength(x_sexp);
+  }
+
+  if (TYPEOF(xy_sexp) == REALSXP && Rf_isMatrix(xy_sexp) && Rf_ncols(xy_sexp) >= 2) {
+    x = REAL_RO(xy_sexp);
+    y = x + Rf_nrows(xy_sexp);
+    return Rf_nrows(xy_sexp);
+  }
+
+  throw std::invalid_argument("Expected list of x, y or double matrix");
+}
+
 struct CellWriter : wk::Handler {
   using Result = wk::Result;
 
-  CellWriter(int res) : res_(res) {}
+  CellWriter(int res, int n_threads) : res_(res), n_threads_(n_threads) {}
 
   Result vector_start(const wk_vector_meta_t* meta) override {
-    if (meta->size != WK_VECTOR_SIZE_UNKNOWN) result_.reserve(meta->size);
+    if (meta->size != WK_VECTOR_SIZE_UNKNOWN) coords_.reserve(meta->size);
+
     return Result::Continue;
   }
 
@@ -39,48 +135,229 @@ struct CellWriter : wk::Handler {
   Result coord(const wk_meta_t* meta, const double* coord) override {
     if (++coord_id_ != 0) throw error("[%i] Feature must contain 0 or 1 coordinate", cur_feat());
 
-    uint64_t cell;
-    LatLng point = {degsToRads(coord[1]), degsToRads(coord[0])};
-    if (auto err = latLngToCell(&point, res_, &cell); err != E_SUCCESS)
-      throw error("[%i] H3 Error: %s", cur_feat(), h3::fmt_error(err));
-
-    result_.push_back(cell);
+    // indexed in bulk by vector_end
+    coords_.push_back({degsToRads(coord[1]), degsToRads(coord[0])});
     return Result::Continue;
   }
 
   Result feature_end(const wk_vector_meta_t* meta) override {
     // didn't write a coordinate?
-    if (coord_id_ == -1) result_.push_back(h3_null);
+    if (coord_id_ == -1) coords_.push_back({NAN, NAN});
+
     return Result::Continue;
   }
 
   SEXP vector_end(const wk_vector_meta_t* meta) override {
-    result_.set_cls(vctrs_cls::h3_cell);
-    return result_;
+    vctr<uint64_t> result(coords_.size());
+    result.set_cls(vctrs_cls::h3_cell);
+
+    points_to_cells(REAL(result), coords_.size(), res_, n_threads_, [this](size_t i, LatLng& point) {
+      point = coords_[i];
+      return !(std::isnan(point.lat) && std::isnan(point.lng));
+    });
+
+    return result;
   }
 
 private:
   int res_;
+  int n_threads_;
   uint64_t feat_id_ = -1;
   uint32_t coord_id_ = -1;
-  vctr<uint64_t, ProtectType::ObjectPreserve> result_;
+  // one coord per feature, NaN lat & lng for null features (as for xy)
+  std::vector<LatLng> coords_;
 
   uint64_t cur_feat() const { return feat_id_ + 1; }
 };
 
+/// cells of points at several resolutions, indexing each point once at the finest
+/// NOTE: coarser cells are parents of the finest cell, which near cell edges can differ from the cell
+/// containing the point
+struct MultiResCellWriter : CellWriter {
+  MultiResCellWriter(std::vector<int> res, int n_threads)
+      : CellWriter(*std::max_element(res.begin(), res.end()), n_threads), res_(std::move(res)) {}
+
+  SEXP vector_end(const wk_vector_meta_t* meta) override {
+    SEXP cells_sexp = PROTECT(CellWriter::vector_end(meta));
+    const double* cells = REAL_RO(cells_sexp);
+    R_xlen_t size = Rf_xlength(cells_sexp);
+
+    vctr<SEXP> result(res_.size());
+    vctr<std::string_view> names(res_.size());
+
+    for (size_t j = 0; j < res_.size(); j++) {
+      int res = res_[j];
+      names[j] = "res" + std::to_string(res);
+
+      vctr<uint64_t> column(size);
+      column.set_cls(vctrs_cls::h3_cell);
+      double* out = REAL(column);
+
+      // parent resolution, digits finer than it unused
+      const uint64_t parent_bits = (uint64_t(res) << H3_RES_OFFSET) | h3::digits_after(res);
+      for (R_xlen_t i = 0; i < size; i++) {
+        auto cell = bp::bit_cast<uint64_t>(cells[i]);
+        out[i] = h3_is_null(cell) ? cells[i] : bp::bit_cast<double>((cell & ~H3_RES_MASK) | parent_bits);
+      }
+
+      result[j] = column;
+    }
+
+    result.set_cls(vctrs_cls::data_frame);
+    Rf_setAttrib(result, R_NamesSymbol, names);
+    Rf_setAttrib(result, R_RowNamesSymbol, vctr<int32_t>{NA_INTEGER, -static_cast<int>(size)});
+    UNPROTECT(1);
+
+    return static_cast<SEXP>(result);
+  }
+
+private:
+  std::vector<int> res_;
+};
+
+/// counts of points in each cell, with the sum of their features' weights
+struct CellCountWriter : wk::Handler {
+  using Result = wk::Result;
+
+  // `weights` (NULL for 1) must outlive the writer
+  CellCountWriter(int res, SEXP weights, int n_threads)
+      : res_(res),
+        n_threads_(parallel::num_threads(n_threads)),
+        batch_size_(parallel::chunk_size * n_threads_),
+        weights_(Rf_isNull(weights) ? nullptr : REAL_RO(weights)),
+        n_weights_(Rf_isNull(weights) ? 0 : Rf_xlength(weights)) {}
+
+  Result vector_start(const wk_vector_meta_t* meta) override {
+    coords_.reserve(batch_size_);
+    feat_ids_.reserve(batch_size_);
+    cells_.resize(batch_size_);
+    return Result::Continue;
+  }
+
+  Result feature_start(const wk_vector_meta_t* meta) override {
+    ++feat_id_;
+    if (weights_ != nullptr && n_weights_ != 1 && feat_id_ >= n_weights_)
+      throw error("[%i] `weights` must be length 1 or the number of features", cur_feat());
+
+    return Result::Continue;
+  }
+
+  Result geometry_start(const wk_meta_t* meta) override {
+    if (meta->size != 0 && !is_in(meta->geometry_type, WK_POINT, WK_MULTIPOINT, WK_GEOMETRYCOLLECTION))
+      throw error("[%i] Cannot convert geometry type '%s' to h3_cell", cur_feat(),
+                  wk::fmt_geometry_type(meta->geometry_type));
+
+    return Result::Continue;
+  }
+
+  Result coord(const wk_meta_t* meta, const double* coord) override {
+    // indexed & counted in batches by flush()
+    coords_.push_back({degsToRads(coord[1]), degsToRads(coord[0])});
+    feat_ids_.push_back(feat_id_);
+    if (coords_.size() >= batch_size_) flush();
+    return Result::Continue;
+  }
+
+  SEXP vector_end(const wk_vector_meta_t* meta) override {
+    flush();
+    if (n_weights_ > 1 && feat_id_ + 1 != n_weights_)
+      throw std::invalid_argument("`weights` must be length 1 or the number of features");
+
+    std::vector<std::pair<uint64_t, CellCounts::Counts>> counts;
+    counts.reserve(counts_.size());
+    counts_.for_each([&counts](uint64_t cell, const CellCounts::Counts& cell_counts) {
+      counts.push_back({cell, cell_counts});
+    });
+    std::sort(counts.begin(), counts.end(), [](const auto& x, const auto& y) { return x.first < y.first; });
+
+    vctr<uint64_t> cells(counts.size());
+    cells.set_cls(vctrs_cls::h3_cell);
+    vctr<double> count(counts.size());
+    vctr<double> weight(counts.size());
+    for (size_t i = 0; i < counts.size(); i++) {
+      cells[i] = counts[i].first;
+      count[i] = counts[i].second.count;
+      weight[i] = counts[i].second.weight;
+    }
+
+    vctr<SEXP> result(3);
+    result[0] = cells;
+    result[1] = count;
+    result[2] = weight;
+    result.set_cls(vctrs_cls::data_frame);
+    Rf_setAttrib(result, R_NamesSymbol, vctr<std::string_view>{"cell", "count", "weight"});
+    Rf_setAttrib(result, R_RowNamesSymbol, vctr<int32_t>{NA_INTEGER, -static_cast<int>(counts.size())});
+
+    return static_cast<SEXP>(result);
+  }
+
+private:
+  int res_;
+  int n_threads_;
+  size_t batch_size_;
+  const double* weights_;
+  R_xlen_t n_weights_;
+  R_xlen_t feat_id_ = -1;
+  // batch of coords & their features, indexed into cells_
+  std::vector<LatLng> coords_;
+  std::vector<R_xlen_t> feat_ids_;
+  std::vector<uint64_t> cells_;
+  CellCounts counts_;
+
+  int64_t cur_feat() const { return feat_id_ + 1; }
+
+  // index the batch across threads, then count it on this one
+  void flush() {
+    size_t i = for_each_point_cell(
+        coords_.size(), res_, n_threads_,
+        [this](size_t i, LatLng& point) {
+          point = coords_[i];
+          return true;
+        },
+        [this](size_t i, uint64_t cell) { cells_[i] = cell; });
+
+    if (i != SIZE_MAX) stop_point(feat_ids_[i] + 1, coords_[i], res_);
+
+    for (size_t j = 0; j < coords_.size(); j++) {
+      double weight = weights_ == nullptr ? 1 : weights_[n_weights_ == 1 ? 0 : feat_ids_[j]];
+      counts_.add(cells_[j], weight);
+    }
+
+    coords_.clear();
+    feat_ids_.clear();
+  }
+};
+
+// polygon fill
+enum class FillMode : int {
+  // cells intersecting the polygon
+  Intersect = 0,
+  // cells whose centroid is within the polygon
+  Center = 1,
+  // cells intersecting the polygon, refining coarse cells on the polygon boundary
+  Hierarchical = 2
+};
+
 struct ListOfCellWriter : wk::Handler {
   using Result = wk::Result;
 
-  ListOfCellWriter(int res) : res_(res) {}
+  ListOfCellWriter(int res, FillMode fill, bool compact, int n_threads)
+      : res_(res),
+        fill_(fill),
+        compact_(compact),
+        n_threads_(parallel::num_threads(n_threads)),
+        // a single thread fills each feature as it ends
+        batch_size_(n_threads_ > 1 ? 256 * n_threads_ : 1),
+        buffers_(n_threads_) {}
 
   Result vector_start(const wk_vector_meta_t* meta) override {
     if (meta->size != WK_VECTOR_SIZE_UNKNOWN) result_.reserve(meta->size);
+    features_.reserve(batch_size_);
     return Result::Continue;
   }
 
   Result feature_start(const wk_vector_meta_t* meta) override {
-    ++feat_id_;
-    cells_.clear();
+    features_.emplace_back();
     return Result::Continue;
   }
 
@@ -90,6 +367,11 @@ struct ListOfCellWriter : wk::Handler {
     return Result::Continue;
   }
 
+  Result ring_start(const wk_meta_t* meta, uint32_t size) override {
+    ring_offset_ = coords_.size();
+    return Result::Continue;
+  }
+
   Result coord(const wk_meta_t* meta, const double* coord) override {
     coords_.push_back({degsToRads(coord[1]), degsToRads(coord[0])});
     return Result::Continue;
@@ -97,51 +379,27 @@ struct ListOfCellWriter : wk::Handler {
 
   Result ring_end(const wk_meta_t* meta, uint32_t size) override {
     // can we trust size?
-    size_t offset = std::accumulate(lengths_.begin(), lengths_.end(), 0UL);
-    lengths_.push_back(coords_.size() - offset);
+    lengths_.push_back(coords_.size() - ring_offset_);
     return Result::Continue;
   }
 
   Result geometry_end(const wk_meta_t* meta) override {
     if (coords_.empty()) return Result::Continue;
 
-    // points
-    if (meta->geometry_type == WK_POINT) {
-      uint64_t cell;
-
-      if (auto err = latLngToCell(&coords_.back(), res_, &cell); err != E_SUCCESS)
-        throw error("[%i] H3 Error: %s", cur_feat(), h3::fmt_error(err));
-
-      cells_.insert(cell);
-    }
-
-    // linestring
-    else if (meta->geometry_type == WK_LINESTRING) {
-      ArcString arc_string(coords_);
-      if (auto err = h3::arcstring_to_cells(arc_string, res_, cells_); err != E_SUCCESS)
-        throw error("[%i] H3 Error: %s", cur_feat(), h3::fmt_error(err));
-    }
-
-    // polygon
-    else if (meta->geometry_type == WK_POLYGON) {
-      CurvedPolygon curved_polygon(coords_, lengths_);
-      if (auto err = h3::curved_polygon_to_cells(curved_polygon, res_, cells_); err != E_SUCCESS)
-        throw error("[%i] H3 Error: %s", cur_feat(), h3::fmt_error(err));
-    }
+    // filled by flush()
+    if (is_in(meta->geometry_type, WK_POINT, WK_LINESTRING, WK_POLYGON))
+      features_.back().geometries.push_back({meta->geometry_type, std::move(coords_), std::move(lengths_)});
 
     return Result::Continue;
   }
 
   Result feature_end(const wk_vector_meta_t* meta) override {
-    vctr<uint64_t> feature_cells(cells_.size());
-    feature_cells.set_cls(vctrs_cls::h3_cell);
-    std::copy(cells_.begin(), cells_.end(), feature_cells.begin());
-    result_.push_back(feature_cells);
-
+    if (features_.size() >= batch_size_) flush();
     return Result::Continue;
   }
 
   SEXP vector_end(const wk_vector_meta_t* meta) override {
+    flush();
     result_.set_cls(vctrs_cls::list_of);
 
     vctr<uint64_t> ptype;
@@ -152,26 +410,399 @@ struct ListOfCellWriter : wk::Handler {
   }
 
 private:
+  struct Geometry {
+    uint32_t geometry_type;
+    std::vector<Coord> coords;
+    std::vector<size_t> lengths;
+  };
+
+  // a decoded feature, waiting to be filled
+  struct Feature {
+    std::vector<Geometry> geometries;
+    CellSet cells;
+    H3Error err = E_SUCCESS;
+  };
+
   int res_;
-  int64_t feat_id_ = -1;
+  FillMode fill_;
+  bool compact_;
+  int n_threads_;
+  size_t batch_size_;
+  // features written to result_
+  int64_t n_flushed_ = 0;
   std::vector<Coord> coords_;
   std::vector<size_t> lengths_;
-  std::unordered_set<uint64_t> cells_;
+  // coords_ index of the current ring's first coord
+  size_t ring_offset_ = 0;
+  std::vector<Feature> features_;
+  // one per thread
+  std::vector<h3::FillBuffers> buffers_;
   vctr<SEXP, ProtectType::ObjectPreserve> result_;
 
-  int64_t cur_feat() const { return feat_id_ + 1; }
+  // fill `feature.cells`, touching nothing but `feature` and `buffers` (no R API!)
+  H3Error fill_feature(Feature& feature, h3::FillBuffers& buffers) const {
+    auto& cells = feature.cells;
+
+    for (const auto& geom : feature.geometries) {
+      H3Error err = E_SUCCESS;
+
+      // points
+      if (geom.geometry_type == WK_POINT) {
+        uint64_t cell;
+        err = latLngToCell(&geom.coords.back(), res_, &cell);
+        if (err == E_SUCCESS) cells.insert(cell);
+      }
+
+      // linestring
+      else if (geom.geometry_type == WK_LINESTRING) {
+        ArcString arc_string(geom.coords);
+        err = h3::arcstring_to_cells(arc_string, res_, cells);
+      }
+
+      // polygon
+      else if (fill_ == FillMode::Center) {
+        err = h3::polygon_to_cells(geom.coords, geom.lengths, res_, cells);
+      }
+
+      else if (fill_ == FillMode::Hierarchical) {
+        CurvedPolygon curved_polygon(geom.coords, geom.lengths);
+        err = h3::curved_polygon_to_compact_cells(curved_polygon, res_, cells, buffers);
+      }
+
+      else {
+        CurvedPolygon curved_polygon(geom.coords, geom.lengths);
+        err = h3::curved_polygon_to_cells(curved_polygon, res_, cells, buffers);
+      }
+
+      if (err != E_SUCCESS) return err;
+    }
+
+    // hierarchical fill leaves coarser cells
+    if (compact_) return h3::compact_cells(cells);
+    if (fill_ == FillMode::Hierarchical) return h3::uncompact_cells(cells, res_);
+    return E_SUCCESS;
+  }
+
+  // fill buffered features across threads, then build their R vectors on this one
+  void flush() {
+    parallel::for_each_chunk(
+        features_.size(), n_threads_,
+        [&](size_t begin, size_t end, size_t worker) {
+          for (size_t i = begin; i < end; i++) features_[i].err = fill_feature(features_[i], buffers_[worker]);
+        },
+        1);
+
+    for (size_t i = 0; i < features_.size(); i++) {
+      const auto& feature = features_[i];
+      if (feature.err != E_SUCCESS)
+        throw error("[%i] H3 Error: %s", n_flushed_ + static_cast<int64_t>(i) + 1, h3::fmt_error(feature.err));
+
+      vctr<uint64_t> feature_cells(feature.cells.size());
+      feature_cells.set_cls(vctrs_cls::h3_cell);
+      std::copy(feature.cells.begin(), feature.cells.end(), feature_cells.begin());
+      result_.push_back(feature_cells);
+    }
+
+    n_flushed_ += features_.size();
+    features_.clear();
+  }
 };
 
-extern "C" SEXP ffi_cell_writer_new(SEXP res_sexp) {
+/// polygons matched to points by their cells at `res`
+///
+/// points in a polygon's interior cells match without geometry tests, leaving point-in-polygon
+/// tests for points in the polygon's boundary cells
+struct PolygonIndex {
+  int res = 0;
+  // interior cells' key ranges (see h3::nest_ranges), by feature
+  std::vector<uint64_t> begins;
+  std::vector<uint64_t> ends;
+  std::vector<int> ids;
+  std::vector<int> parents;
+  // boundary cells & the polygons they intersect, sorted by cell
+  std::vector<std::pair<uint64_t, uint32_t>> boundary;
+  std::vector<CurvedPolygon> polygons;
+  std::vector<int> polygon_ids;
+
+  /// id of the first feature containing `point`, whose cell at `res` is `cell`, or NA_INTEGER
+  int find(uint64_t cell, const LatLng& point) const {
+    int i = h3::find_range(begins.data(), ends.data(), parents.data(), begins.size(), cell);
+    int id = i >= 0 ? ids[i] : INT_MAX;
+
+    auto it = std::lower_bound(boundary.begin(), boundary.end(), std::make_pair(cell, uint32_t{0}));
+    if (it != boundary.end() && it->first == cell) {
+      NVector coord = NVector::from_coord({point});
+      for (; it != boundary.end() && it->first == cell; ++it) {
+        int polygon_id = polygon_ids[it->second];
+        if (polygon_id < id && polygons[it->second].contains(coord)) id = polygon_id;
+      }
+    }
+
+    return id == INT_MAX ? NA_INTEGER : id;
+  }
+};
+
+void polygon_index_finalize(SEXP index_xptr) {
+  delete static_cast<PolygonIndex*>(R_ExternalPtrAddr(index_xptr));
+  R_ClearExternalPtr(index_xptr);
+}
+
+struct PolygonIndexWriter : wk::Handler {
+  using Result = wk::Result;
+
+  PolygonIndexWriter(int res, int n_threads)
+      : n_threads_(parallel::num_threads(n_threads)),
+        batch_size_(256 * n_threads_),
+        buffers_(n_threads_),
+        index_(new PolygonIndex()) {
+    index_->res = res;
+  }
+
+  Result vector_start(const wk_vector_meta_t* meta) override {
+    polygons_.reserve(batch_size_);
+    return Result::Continue;
+  }
+
+  Result feature_start(const wk_vector_meta_t* meta) override {
+    ++feat_id_;
+    return Result::Continue;
+  }
+
+  Result geometry_start(const wk_meta_t* meta) override {
+    if (meta->size != 0 && !is_in(meta->geometry_type, WK_POLYGON, WK_MULTIPOLYGON, WK_GEOMETRYCOLLECTION))
+      throw error("[%i] Cannot join geometry type '%s' to points", cur_feat(),
+                  wk::fmt_geometry_type(meta->geometry_type));
+
+    coords_.clear();
+    lengths_.clear();
+    return Result::Continue;
+  }
+
+  Result ring_start(const wk_meta_t* meta, uint32_t size) override {
+    ring_offset_ = coords_.size();
+    return Result::Continue;
+  }
+
+  Result coord(const wk_meta_t* meta, const double* coord) override {
+    coords_.push_back({degsToRads(coord[1]), degsToRads(coord[0])});
+    return Result::Continue;
+  }
+
+  Result ring_end(const wk_meta_t* meta, uint32_t size) override {
+    lengths_.push_back(coords_.size() - ring_offset_);
+    return Result::Continue;
+  }
+
+  Result geometry_end(const wk_meta_t* meta) override {
+    if (meta->geometry_type != WK_POLYGON || coords_.empty()) return Result::Continue;
+
+    // filled by flush()
+    auto& polygon = polygons_.emplace_back();
+    polygon.id = static_cast<int>(cur_feat());
+    polygon.coords = std::move(coords_);
+    polygon.lengths = std::move(lengths_);
+    if (polygons_.size() >= batch_size_) flush();
+    return Result::Continue;
+  }
+
+  SEXP vector_end(const wk_vector_meta_t* meta) override {
+    flush();
+
+    h3::nest_ranges(ranges_);
+    for (const auto& range : ranges_) {
+      index_->begins.push_back(range.begin);
+      index_->ends.push_back(range.end);
+      index_->ids.push_back(range.id);
+      index_->parents.push_back(range.parent);
+    }
+    std::sort(index_->boundary.begin(), index_->boundary.end());
+
+    SEXP index_xptr = PROTECT(R_MakeExternalPtr(nullptr, R_NilValue, R_NilValue));
+    R_RegisterCFinalizerEx(index_xptr, polygon_index_finalize, TRUE);
+    R_SetExternalPtrAddr(index_xptr, index_.release());
+    UNPROTECT(1);
+
+    return index_xptr;
+  }
+
+private:
+  // a decoded polygon, waiting to be filled
+  struct Polygon {
+    int id = 0;
+    std::vector<Coord> coords;
+    std::vector<size_t> lengths;
+    CurvedPolygon polygon;
+    std::vector<uint64_t> interior_cells;
+    std::vector<uint64_t> boundary_cells;
+    H3Error err = E_SUCCESS;
+  };
+
+  int n_threads_;
+  size_t batch_size_;
+  uint64_t feat_id_ = -1;
+  std::vector<Coord> coords_;
+  std::vector<size_t> lengths_;
+  // coords_ index of the current ring's first coord
+  size_t ring_offset_ = 0;
+  std::vector<Polygon> polygons_;
+  // one per thread
+  std::vector<h3::FillBuffers> buffers_;
+  std::vector<h3::KeyRange> ranges_;
+  std::unique_ptr<PolygonIndex> index_;
+
+  uint64_t cur_feat() const { return feat_id_ + 1; }
+
+  // split `polygon` into interior & boundary cells, touching nothing but `polygon` and `buffers` (no R API!)
+  H3Error fill_polygon(Polygon& polygon, h3::FillBuffers& buffers) const {
+    polygon.polygon = CurvedPolygon(polygon.coords, polygon.lengths);
+
+    // coarse interior cells & edge cells (with their neighbours) at res
+    CellSet cells;
+    auto err = h3::curved_polygon_to_compact_cells(polygon.polygon, index_->res, cells, buffers, true);
+    if (err != E_SUCCESS) return err;
+
+    const auto& edge_cells = buffers.edge_cells;
+    polygon.boundary_cells.assign(edge_cells.begin(), edge_cells.end());
+    std::copy_if(cells.begin(), cells.end(), std::back_inserter(polygon.interior_cells),
+                 [&edge_cells](uint64_t cell) { return !edge_cells.count(cell); });
+
+    return E_SUCCESS;
+  }
+
+  // fill buffered polygons across threads, then add them to the index on this one
+  void flush() {
+    parallel::for_each_chunk(
+        polygons_.size(), n_threads_,
+        [&](size_t begin, size_t end, size_t worker) {
+          for (size_t i = begin; i < end; i++) polygons_[i].err = fill_polygon(polygons_[i], buffers_[worker]);
+        },
+        1);
+
+    for (auto& polygon : polygons_) {
+      if (polygon.err != E_SUCCESS) throw error("[%i] H3 Error: %s", polygon.id, h3::fmt_error(polygon.err));
+
+      for (auto cell : polygon.interior_cells)
+        ranges_.push_back({h3::compact::first_key(cell), h3::compact::key(cell), polygon.id, -1});
+
+      auto i = static_cast<uint32_t>(index_->polygons.size());
+      for (auto cell : polygon.boundary_cells) index_->boundary.push_back({cell, i});
+
+      index_->polygons.push_back(std::move(polygon.polygon));
+      index_->polygon_ids.push_back(polygon.id);
+    }
+
+    polygons_.clear();
+  }
+};
+
+extern "C" SEXP ffi_cell_writer_new(SEXP res_sexp, SEXP n_threads_sexp) {
   return catch_unwind([&] {
     int res = Rf_asInteger(res_sexp);
-    return wk::HandlerFactory<CellWriter>::create_xptr(new CellWriter(res));
+    int n_threads = Rf_asInteger(n_threads_sexp);
+    return wk::HandlerFactory<CellWriter>::create_xptr(new CellWriter(res, n_threads));
   });
 }
 
-extern "C" SEXP ffi_listof_cell_writer_new(SEXP res_sexp) {
+extern "C" SEXP ffi_multires_cell_writer_new(SEXP res_sexp, SEXP n_threads_sexp) {
+  return catch_unwind([&] {
+    vctr_view<int32_t> res_view = res_sexp;
+    std::vector<int> res(res_view.begin(), res_view.end());
+    if (res.empty() || std::any_of(res.begin(), res.end(), [](int r) { return r < 0 || r > MAX_H3_RES; }))
+      throw error("H3 Error: %s", h3::fmt_error(E_RES_DOMAIN));
+
+    int n_threads = Rf_asInteger(n_threads_sexp);
+    return wk::HandlerFactory<MultiResCellWriter>::create_xptr(new MultiResCellWriter(std::move(res), n_threads));
+  });
+}
+
+extern "C" SEXP ffi_cell_count_writer_new(SEXP res_sexp, SEXP weights_sexp, SEXP n_threads_sexp) {
   return catch_unwind([&] {
     int res = Rf_asInteger(res_sexp);
-    return wk::HandlerFactory<ListOfCellWriter>::create_xptr(new ListOfCellWriter(res));
+    if (res < 0 || res > MAX_H3_RES) throw error("H3 Error: %s", h3::fmt_error(E_RES_DOMAIN));
+    if (!Rf_isNull(weights_sexp) && TYPEOF(weights_sexp) != REALSXP)
+      throw std::invalid_argument("Expected double weights");
+
+    int n_threads = Rf_asInteger(n_threads_sexp);
+    return wk::HandlerFactory<CellCountWriter>::create_xptr(new CellCountWriter(res, weights_sexp, n_threads),
+                                                            R_NilValue, weights_sexp);
+  });
+}
+
+extern "C" SEXP ffi_listof_cell_writer_new(SEXP res_sexp, SEXP fill_sexp, SEXP compact_sexp,
+                                           SEXP n_threads_sexp) {
+  return catch_unwind([&] {
+    int res = Rf_asInteger(res_sexp);
+    auto fill = FillMode{Rf_asInteger(fill_sexp)};
+    bool compact = Rf_asLogical(compact_sexp);
+    int n_threads = Rf_asInteger(n_threads_sexp);
+    return wk::HandlerFactory<ListOfCellWriter>::create_xptr(
+        new ListOfCellWriter(res, fill, compact, n_threads));
+  });
+}
+
+extern "C" SEXP ffi_xy_to_cell(SEXP xy_sexp, SEXP res_sexp, SEXP n_threads_sexp) {
+  return catch_unwind([&] {
+    int res = Rf_asInteger(res_sexp);
+    int n_threads = Rf_asInteger(n_threads_sexp);
+
+    const double* x;
+    const double* y;
+    size_t size = read_xy(xy_sexp, x, y);
+
+    vctr<uint64_t> result(size);
+    result.set_cls(vctrs_cls::h3_cell);
+
+    // empty points are NA in every dimension
+    points_to_cells(REAL(result), size, res, n_threads, [&](size_t i, LatLng& point) {
+      point = {degsToRads(y[i]), degsToRads(x[i])};
+      return !(std::isnan(x[i]) && std::isnan(y[i]));
+    });
+
+    return static_cast<SEXP>(result);
+  });
+}
+
+extern "C" SEXP ffi_polygon_index_writer_new(SEXP res_sexp, SEXP n_threads_sexp) {
+  return catch_unwind([&] {
+    int res = Rf_asInteger(res_sexp);
+    if (res < 0 || res > MAX_H3_RES) throw error("H3 Error: %s", h3::fmt_error(E_RES_DOMAIN));
+
+    int n_threads = Rf_asInteger(n_threads_sexp);
+    return wk::HandlerFactory<PolygonIndexWriter>::create_xptr(new PolygonIndexWriter(res, n_threads));
+  });
+}
+
+extern "C" SEXP ffi_polygon_index_join(SEXP index_xptr, SEXP xy_sexp, SEXP n_threads_sexp) {
+  return catch_unwind([&] {
+    auto* index = static_cast<PolygonIndex*>(R_ExternalPtrAddr(index_xptr));
+    if (index == nullptr) throw std::invalid_argument("Polygon index is no longer valid");
+
+    int n_threads = Rf_asInteger(n_threads_sexp);
+
+    const double* x;
+    const double* y;
+    size_t size = read_xy(xy_sexp, x, y);
+
+    vctr<int32_t> result(size);
+    int* out = INTEGER(result);
+
+    auto point_at = [&](size_t i, LatLng& point) {
+      point = {degsToRads(y[i]), degsToRads(x[i])};
+      return !(std::isnan(x[i]) && std::isnan(y[i]));
+    };
+
+    size_t i = for_each_point_cell(size, index->res, n_threads, point_at, [&](size_t i, uint64_t cell) {
+      LatLng point;
+      point_at(i, point);
+      out[i] = h3_is_null(cell) ? NA_INTEGER : index->find(cell, point);
+    });
+
+    if (i != SIZE_MAX) {
+      LatLng point;
+      point_at(i, point);
+      stop_point(i + 1, point, index->res);
+    }
+
+    return static_cast<SEXP>(result);
   });
 }